@@ -3,6 +3,8 @@
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifndef false
 #define false 0
@@ -20,15 +22,166 @@ typedef enum {
     THREADPOOL_QUEUE_FULL = -3,  // 任务队列已满
     THREADPOOL_SHUTDOWN = -4,    // 线程池已关闭
     THREADPOOL_THREAD_FAILURE = -5,// 线程创建失败
-    THREADPOOL_MEMORY_ERROR = -6 // 内存分配失败
+    THREADPOOL_MEMORY_ERROR = -6,// 内存分配失败
+    THREADPOOL_TIMEOUT = -7,     // 等待超时（或结果尚未就绪）
+    THREADPOOL_CANCELLED = -8,   // 任务在执行前被取消
+    THREADPOOL_IO_ERROR = -9     // 文件读写失败
 } threadpool_error_t;
 
+/* 任务优先级（数值越小越优先） */
+typedef enum {
+    THREADPOOL_PRIORITY_CRITICAL = 0, // 延迟敏感
+    THREADPOOL_PRIORITY_HIGH = 1,
+    THREADPOOL_PRIORITY_NORMAL = 2,   // threadpool_add 等接口的默认级别
+    THREADPOOL_PRIORITY_LOW = 3       // 后台批处理
+} threadpool_priority_t;
+
+#define THREADPOOL_PRIORITY_LEVELS 4
+
+/* 工作线程空闲策略 */
+typedef enum {
+    THREADPOOL_IDLE_ADAPTIVE = 0, // 自旋(pause) -> 让出CPU(sched_yield) -> futex 休眠（默认）
+    THREADPOOL_IDLE_PARK = 1,     // 没有任务时立即 futex 休眠，最省CPU
+    THREADPOOL_IDLE_SPIN = 2      // 只自旋/让出CPU、从不休眠，适合独占CPU的低延迟场景
+} threadpool_idle_policy_t;
+
+/* 全局任务队列实现 */
+typedef enum {
+    THREADPOOL_QUEUE_LOCKFREE = 0, // 无锁 MPMC 环形队列，任务按值存放（默认）
+    THREADPOOL_QUEUE_LOCKED = 1    // 互斥锁 + ring_queue，内存占用小，适合提交并发低的场景
+} threadpool_queue_impl_t;
+
+/* 工作线程CPU绑定策略（候选CPU为 cpu_list，未指定时为进程当前允许的CPU） */
+typedef enum {
+    THREADPOOL_AFFINITY_NONE = 0,     // 不单独绑定；指定 cpu_list 时所有线程共用该CPU集合（默认）
+    THREADPOOL_AFFINITY_COMPACT = 1,  // 按 NUMA 节点、CPU 编号顺序逐个绑定，线程尽量集中在同一节点
+    THREADPOOL_AFFINITY_SCATTER = 2,  // 轮流分布到各 NUMA 节点，再在节点内逐个绑定CPU
+    THREADPOOL_AFFINITY_EXPLICIT = 3, // 第 i 个线程绑定 cpu_list[i % cpu_count]（须指定 cpu_list）
+    THREADPOOL_AFFINITY_NUMA = 4      // 每个 NUMA 节点一个分区：独立的全局队列与绑定到本节点的内部内存池，
+                                      // 线程绑定到所在节点的CPU集合，优先执行本分区任务
+} threadpool_affinity_t;
+
+/* 默认自旋轮数与让出CPU轮数（THREADPOOL_IDLE_ADAPTIVE） */
+#define THREADPOOL_DEFAULT_SPIN_COUNT 2000
+#define THREADPOOL_DEFAULT_YIELD_COUNT 16
+/* 默认全局队列初始容量（无限制模式） */
+#define THREADPOOL_DEFAULT_QUEUE_CAPACITY 1024
+/* 默认预热的 future/任务组状态块数 */
+#define THREADPOOL_DEFAULT_FUTURE_PREALLOC 256
+/* 默认内部内存池对齐字节数 */
+#define THREADPOOL_DEFAULT_TASK_POOL_ALIGNMENT 64
+/* 默认空闲线程保留时长（毫秒），超出下限的线程空闲这么久后退出 */
+#define THREADPOOL_DEFAULT_KEEPALIVE_MS 60000
+/* 默认新建线程阈值：没有空闲线程且待执行任务数达到此值时新建线程 */
+#define THREADPOOL_DEFAULT_GROW_THRESHOLD 1
+/* 工作线程数上限（threadpool_resize 与 max_threads 不能超过此值，除非初始线程数更大） */
+#define THREADPOOL_MAX_THREADS 256
+
+/* 内联参数缓冲区大小（字节），参见 threadpool_add_inline */
+#define THREADPOOL_INLINE_SIZE 48
+
 /* 任务函数类型 */
 typedef void (*threadpool_task_func)(void *arg);
 
+/* 带返回值的任务函数类型（用于 future） */
+typedef void *(*threadpool_future_func)(void *arg);
+
+/* 区间任务函数类型（用于 parallel_for），处理 [begin, end) */
+typedef void (*threadpool_range_func)(size_t begin, size_t end, void *ctx);
+
+/* 线程池运行统计（threadpool_get_stats 汇总，计数自创建起累计） */
+typedef struct threadpool_stats {
+    uint64_t submitted;                  // 已接受的任务数
+    uint64_t completed;                  // 已执行完成的任务数
+    uint64_t rejected;                   // 因队列已满或已关闭被拒绝的任务数
+    uint64_t cancelled;                  // 未执行即被丢弃的任务数（立即销毁）
+    uint64_t local_pushes;               // 进入工作线程本地队列的任务数
+    uint64_t steals;                     // 从其他工作线程窃取成功的次数
+    uint64_t alloc_fixed;                // 溢出节点分配：内存池固定大小类别
+    uint64_t alloc_pool;                 // 溢出节点分配：内存池通用分配
+    uint64_t alloc_malloc;               // 溢出节点分配：回退到 malloc
+    uint64_t busy_ns;                    // 所有工作线程处于活动状态（执行/查找任务）的总时间
+    uint64_t idle_ns;                    // 所有工作线程等待任务（自旋/让出CPU/休眠）的总时间
+    int queue_depth;                     // 当前待执行任务数
+    int queue_high_water;                // 待执行任务数的历史最大值
+    int threads;                         // 正在运行的工作线程数
+} threadpool_stats_t;
+
+/* 任务延迟类别 */
+typedef enum {
+    THREADPOOL_LATENCY_WAIT = 0,         // 排队时间：提交 -> 开始执行
+    THREADPOOL_LATENCY_RUN = 1           // 执行时间
+} threadpool_latency_kind_t;
+
+/* 任务延迟分布（对数-线性直方图汇总，分位数相对误差约 6%） */
+typedef struct threadpool_latency {
+    uint64_t count;                      // 样本数
+    uint64_t min_ns;                     // 最小值
+    uint64_t max_ns;                     // 最大值
+    uint64_t mean_ns;                    // 平均值
+    uint64_t p50_ns;                     // 中位数
+    uint64_t p99_ns;                     // 99 分位
+    uint64_t p999_ns;                    // 99.9 分位
+} threadpool_latency_t;
+
+/* 单个工作线程（槽位）的运行统计，槽位被复用时累计 */
+typedef struct threadpool_worker_stats {
+    int index;                           // 工作线程编号
+    bool running;                        // 当前是否有线程运行
+    uint64_t submitted;                  // 该线程内部提交的任务数
+    uint64_t completed;                  // 执行完成的任务数
+    uint64_t local_pushes;               // 进入本地队列的任务数
+    uint64_t steals;                     // 窃取成功的次数
+    uint64_t busy_ns;                    // 活动时间
+    uint64_t idle_ns;                    // 等待任务的时间
+} threadpool_worker_stats_t;
+
 /* 线程池结构体 */
 typedef struct threadpool_t threadpool_t;
 
+/* 内存池（见 Third/Include/mempool/memory_pool.h，仅 threadpool_warmup_memory_pool 使用） */
+struct memory_pool;
+
+/* 线程池配置（先用 threadpool_config_default 填充默认值，再修改需要的字段） */
+typedef struct threadpool_config {
+    // 线程与队列
+    int thread_count;                    // 初始线程数量（<=0 使用默认值4）
+    int min_threads;                     // 线程数下限（0 表示等于 thread_count）
+    int max_threads;                     // 线程数上限（0 表示等于 thread_count，即固定线程数）
+    int keepalive_ms;                    // 超出下限的线程空闲多久后退出（0 使用默认值，<0 不退出）
+    int grow_threshold;                  // 没有空闲线程时，待执行任务数达到多少新建线程（0 使用默认值）
+    bool latency_stats;                  // 记录任务排队/执行时间分布（每个任务多读三次时钟，默认关闭）
+    size_t trace_capacity;               // 每个线程跟踪缓冲区保留的事件数（向上取整为 2 的幂，0 表示不跟踪）
+    int queue_size;                      // 任务队列大小上限（0表示无限）
+    threadpool_queue_impl_t queue_impl;  // 全局任务队列实现
+    size_t queue_capacity;               // 无限制模式下每级全局队列的初始容量（0 使用默认值）
+
+    // 内部内存池（溢出节点、future、任务组）
+    size_t task_pool_size;               // 初始字节数（0 按预热数量自动计算）
+    uint32_t task_pool_alignment;        // 块对齐字节数（2 的幂，0 使用默认值）
+    size_t future_prealloc;              // 预热的 future/任务组状态块数
+    size_t overflow_prealloc;            // 预热的溢出节点数（0 使用队列容量）
+
+    // 空闲策略
+    threadpool_idle_policy_t idle_policy;// 空闲策略
+    int spin_count;                      // 休眠前的自旋轮数（单CPU机器上忽略）
+    int yield_count;                     // 自旋之后、休眠之前让出CPU的轮数
+
+    // 工作线程属性
+    size_t stack_size;                   // 线程栈大小（0 使用系统默认）
+    size_t guard_size;                   // 栈保护区大小（0 使用系统默认）
+    const int *cpu_list;                 // 允许运行的CPU编号数组（NULL 表示不限制）
+    int cpu_count;                       // cpu_list 长度
+    threadpool_affinity_t affinity;      // CPU绑定策略
+    const char *name_prefix;             // 线程名前缀，线程名为 "<前缀>-<编号>"（NULL 不命名，超长截断）
+} threadpool_config_t;
+
+/* 任务结果句柄 */
+typedef struct threadpool_future threadpool_future_t;
+
+/* 任务组 */
+typedef struct threadpool_group threadpool_group_t;
+
 /**
  * 创建线程池
  * 
@@ -38,6 +191,21 @@ typedef struct threadpool_t threadpool_t;
  */
 threadpool_t *threadpool_create(int thread_count, int queue_size);
 
+/**
+ * 用默认值填充线程池配置（与 threadpool_create 的行为一致）
+ *
+ * @param config 线程池配置
+ */
+void threadpool_config_default(threadpool_config_t *config);
+
+/**
+ * 按配置创建线程池
+ *
+ * @param config 线程池配置
+ * @return 成功返回线程池指针，失败返回NULL
+ */
+threadpool_t *threadpool_create_with_config(const threadpool_config_t *config);
+
 /**
  * 向线程池添加任务
  * 
@@ -48,6 +216,269 @@ threadpool_t *threadpool_create(int thread_count, int queue_size);
  */
 int threadpool_add(threadpool_t *pool, threadpool_task_func function, void *argument);
 
+/**
+ * 按优先级向线程池添加任务
+ *
+ * 每个优先级有独立的全局队列，工作线程先取高级别任务。为防止低级别任务
+ * 饥饿，某级别有任务却被更高级别连续越过一定次数后会被优先服务一次（老化）。
+ * 优先级只影响取任务的顺序，不会抢占正在执行的任务。
+ *
+ * @param pool 线程池指针
+ * @param function 任务函数
+ * @param argument 任务参数
+ * @param priority 优先级（THREADPOOL_PRIORITY_*）
+ * @return 成功返回0，失败返回错误码
+ */
+int threadpool_add_priority(threadpool_t *pool, threadpool_task_func function, void *argument,
+                            threadpool_priority_t priority);
+
+/**
+ * 向线程池添加携带内联参数的任务
+ *
+ * 参数数据被拷贝进任务本身（随任务按值存放在队列中），调用方无需为参数
+ * 单独分配内存。任务函数收到的指针指向该副本，按8字节对齐，仅在任务
+ * 执行期间有效。
+ *
+ * @param pool 线程池指针
+ * @param function 任务函数
+ * @param data 参数数据
+ * @param size 参数字节数（不超过 THREADPOOL_INLINE_SIZE）
+ * @return 成功返回0，失败返回错误码
+ */
+int threadpool_add_inline(threadpool_t *pool, threadpool_task_func function,
+                          const void *data, size_t size);
+
+/**
+ * 向指定工作线程定向投递任务
+ *
+ * 任务进入该线程的单生产者单消费者收件箱，由该线程在查找其他任务之前
+ * 执行，不会被其他线程窃取，适合需要固定线程（缓存亲和、线程局部状态）
+ * 的任务。每个工作线程由一个提交方固定投递时全程无锁；多个提交方投递给
+ * 同一线程时在投递方互斥（自旋）。工作线程编号为 0 ~ 当前线程数-1。
+ * 目标线程退出（threadpool_resize 调小或空闲超时）前会执行完已接受的任务，
+ * 立即关闭时取消。
+ *
+ * 注意：任务内部等待的结果若依赖之后才投递给本线程的任务，可能死锁。
+ *
+ * @param pool 线程池指针
+ * @param worker 工作线程编号
+ * @param function 任务函数
+ * @param argument 函数参数
+ * @return 成功返回0；编号无效或该线程未在运行返回 THREADPOOL_INVALID，
+ *         收件箱已满返回 THREADPOOL_QUEUE_FULL，其他失败返回错误码
+ */
+int threadpool_add_to(threadpool_t *pool, int worker, threadpool_task_func function, void *argument);
+
+/**
+ * 批量向线程池添加任务
+ *
+ * 整批任务一次性预占队列名额、批量入队，并唤醒 min(count, 空闲线程数)
+ * 个工作线程。有队列上限时只提交剩余容量内的前若干个任务。
+ *
+ * @param pool 线程池指针
+ * @param functions 任务函数数组（长度为 count，不能含 NULL）
+ * @param arguments 任务参数数组（长度为 count，可为 NULL 表示参数全为 NULL）
+ * @param count 任务数量
+ * @return 成功返回实际提交的任务数（从数组开头起连续的前若干个），
+ *         一个也未提交时返回错误码
+ */
+int threadpool_add_batch(threadpool_t *pool, const threadpool_task_func *functions,
+                         void *const *arguments, int count);
+
+/**
+ * 提交带结果句柄的任务
+ *
+ * 完成状态从线程池内部的内存池分配，等待基于 futex，不需要调用方准备
+ * 互斥锁和条件变量。句柄必须由调用方通过 threadpool_future_destroy 释放
+ * （可在任务完成前释放，也可在线程池销毁后释放）。
+ *
+ * @param pool 线程池指针
+ * @param function 任务函数，返回值作为任务结果
+ * @param argument 任务参数
+ * @return 成功返回句柄，失败（参数无效、队列已满、已关闭或内存不足）返回NULL
+ */
+threadpool_future_t *threadpool_submit_future(threadpool_t *pool, threadpool_future_func function,
+                                              void *argument);
+
+/**
+ * 阻塞等待任务完成并获取结果
+ *
+ * @param future 任务句柄
+ * @param result 输出任务返回值（可为 NULL）
+ * @return 成功返回0；任务因立即销毁线程池而被丢弃返回 THREADPOOL_CANCELLED
+ */
+int threadpool_future_wait(threadpool_future_t *future, void **result);
+
+/**
+ * 非阻塞获取任务结果
+ *
+ * @param future 任务句柄
+ * @param result 输出任务返回值（可为 NULL）
+ * @return 已完成返回0，尚未完成返回 THREADPOOL_TIMEOUT，已取消返回 THREADPOOL_CANCELLED
+ */
+int threadpool_future_try_get(threadpool_future_t *future, void **result);
+
+/**
+ * 限时等待任务完成并获取结果
+ *
+ * @param future 任务句柄
+ * @param timeout_ms 最长等待毫秒数
+ * @param result 输出任务返回值（可为 NULL）
+ * @return 已完成返回0，超时返回 THREADPOOL_TIMEOUT，已取消返回 THREADPOOL_CANCELLED
+ */
+int threadpool_future_wait_for(threadpool_future_t *future, long timeout_ms, void **result);
+
+/**
+ * 释放任务句柄（不等待任务完成，也不取消任务）
+ *
+ * @param future 任务句柄
+ */
+void threadpool_future_destroy(threadpool_future_t *future);
+
+/**
+ * 创建任务组
+ *
+ * 任务组用于等待一批任务全部完成（fork/join），线程池无需销毁即可复用。
+ *
+ * @param pool 线程池指针
+ * @return 成功返回任务组指针，失败返回NULL
+ */
+threadpool_group_t *threadpool_group_create(threadpool_t *pool);
+
+/**
+ * 向任务组添加任务
+ *
+ * @param group 任务组指针
+ * @param function 任务函数
+ * @param argument 任务参数
+ * @return 成功返回0，失败返回错误码
+ */
+int threadpool_group_add(threadpool_group_t *group, threadpool_task_func function, void *argument);
+
+/**
+ * 等待任务组中已添加的任务全部完成
+ *
+ * 在本线程池的工作线程内部调用时，等待期间会代为执行队列中的任务而不是
+ * 阻塞，因此任务内部可以递归地创建并等待子任务组。返回后任务组可继续使用。
+ *
+ * @param group 任务组指针
+ * @return 全部执行完成返回0；有任务因立即销毁线程池而被丢弃返回 THREADPOOL_CANCELLED
+ */
+int threadpool_group_wait(threadpool_group_t *group);
+
+/**
+ * 销毁任务组（先等待组内任务全部完成）
+ *
+ * @param group 任务组指针
+ */
+void threadpool_group_destroy(threadpool_group_t *group);
+
+/**
+ * 并行执行区间 [begin, end)
+ *
+ * 区间按惰性二分拆分：执行方每处理完 grain 个元素检查一次，仅当自己的本地
+ * 队列已被窃取一空或有空闲线程时才把剩余区间的后一半分出去，因此分块数量
+ * 随实际并行度自适应，而不是预先切成固定的小块。调用线程参与执行，返回时
+ * 整个区间都已处理完毕。可在任务内部嵌套调用。
+ *
+ * @param pool 线程池指针
+ * @param begin 区间起点
+ * @param end 区间终点（不含）
+ * @param grain 最小分块大小（0 表示按线程数自动选择）
+ * @param function 区间任务函数，每次处理一个子区间
+ * @param ctx 传给任务函数的上下文
+ * @return 成功返回0；有子区间因立即销毁线程池而被丢弃返回 THREADPOOL_CANCELLED
+ */
+int threadpool_parallel_for(threadpool_t *pool, size_t begin, size_t end, size_t grain,
+                            threadpool_range_func function, void *ctx);
+
+/**
+ * 在线程池上并行预热内存池
+ *
+ * 把 memory_pool 整条池链（含子池）切成按页对齐的分块，用 threadpool_parallel_for
+ * 分给各线程缺页（MADV_POPULATE_WRITE，内核不支持时逐页原子加0，不改变内容），
+ * 启动耗时随线程数下降。页面仍按内存池创建时的 NUMA 绑定分配，与执行预热的线程
+ * 在哪个节点无关。
+ * 不要与该内存池的 trim 或 destroy 并发调用。
+ *
+ * @param pool 线程池指针
+ * @param mem 内存池指针
+ * @return 成功返回0，参数无效返回 THREADPOOL_INVALID，其余同 threadpool_parallel_for
+ */
+int threadpool_warmup_memory_pool(threadpool_t *pool, struct memory_pool *mem);
+
+/**
+ * 调整线程数量
+ *
+ * 固定线程数的线程池（min_threads == max_threads）调整为恰好 thread_count 个
+ * 线程；动态线程池把上限设为 thread_count（下限高于它时一并调低）。多出的线程
+ * 在完成当前任务、本地队列为空后退出，不足下限的立即新建。
+ *
+ * @param pool 线程池指针
+ * @param thread_count 线程数量（1 ~ THREADPOOL_MAX_THREADS）
+ * @return 成功返回0，线程创建失败返回 THREADPOOL_THREAD_FAILURE，其他失败返回错误码
+ */
+int threadpool_resize(threadpool_t *pool, int thread_count);
+
+/**
+ * 获取线程池运行统计
+ *
+ * 计数按工作线程分别维护（外部提交方按线程分散到若干计数槽），只在调用本函数时
+ * 汇总，热路径之间没有共享写。各项分别读取，并发运行时彼此之间不是同一时刻的快照。
+ *
+ * @param pool 线程池指针
+ * @param stats 输出统计
+ * @return 成功返回0，失败返回错误码
+ */
+int threadpool_get_stats(threadpool_t *pool, threadpool_stats_t *stats);
+
+/**
+ * 获取各工作线程的运行统计
+ *
+ * @param pool 线程池指针
+ * @param stats 输出数组
+ * @param count 数组长度
+ * @return 成功返回写入的项数（曾经使用过的槽位，最多 count 个），失败返回错误码
+ */
+int threadpool_get_worker_stats(threadpool_t *pool, threadpool_worker_stats_t *stats, int count);
+
+/**
+ * 获取任务延迟分布（需创建时开启 latency_stats）
+ *
+ * 各工作线程分别记录直方图，调用时合并。
+ *
+ * @param pool 线程池指针
+ * @param kind 延迟类别
+ * @param latency 输出延迟分布
+ * @return 成功返回0，未开启 latency_stats 或参数无效返回 THREADPOOL_INVALID
+ */
+int threadpool_get_latency(threadpool_t *pool, threadpool_latency_kind_t kind, threadpool_latency_t *latency);
+
+/**
+ * 获取任务延迟的任意分位数（需创建时开启 latency_stats）
+ *
+ * @param pool 线程池指针
+ * @param kind 延迟类别
+ * @param percentile 分位（0 ~ 100，如 99.9）
+ * @param value_ns 输出该分位的延迟（纳秒），没有样本时为0
+ * @return 成功返回0，未开启 latency_stats 或参数无效返回 THREADPOOL_INVALID
+ */
+int threadpool_latency_percentile(threadpool_t *pool, threadpool_latency_kind_t kind,
+                                  double percentile, uint64_t *value_ns);
+
+/**
+ * 将跟踪事件导出为 Chrome trace JSON（需创建时设置 trace_capacity）
+ *
+ * 每个工作线程与外部提交方分片各有一个环形缓冲区，只保留最近的 trace_capacity 个事件。
+ * 导出文件可用 chrome://tracing 或 https://ui.perfetto.dev 打开。
+ * 导出期间线程池可以继续运行，正在写入的少量事件可能缺失。
+ *
+ * @param pool 线程池指针
+ * @param path 输出文件路径
+ * @return 成功返回0，未开启跟踪或参数无效返回 THREADPOOL_INVALID，写文件失败返回 THREADPOOL_IO_ERROR
+ */
+int threadpool_trace_dump(threadpool_t *pool, const char *path);
+
 /**
  * 销毁线程池
  * 
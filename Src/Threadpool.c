@@ -1,556 +1,3271 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // pthread_attr_setaffinity_np / pthread_setname_np
+#endif
 #include "../Include/Threadpool.h"
 #include "../Third/Include/ring_queue/ring_queue.h"
+#include "../Third/Include/ring_queue/ring_queue_mpmc.h"
+#include "../Third/Include/ring_queue/ring_queue_spsc.h"
+#include "../Third/Include/ws_deque/ws_deque.h"
 #include "../Third/Include/mempool/memory_pool.h"
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
 #include <unistd.h>
-#ifdef DEBUG
+#include <sched.h>
 #include <stdio.h>
-#endif
+#include <stdatomic.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
+
+// 每个工作线程本地双端队列容量（满时回退到全局队列）
+#define THREADPOOL_LOCAL_DEQUE_SIZE 1024
+// 每个工作线程定向投递收件箱容量（见 threadpool_add_to）
+#define THREADPOOL_INBOX_SIZE 256
+// 批量提交时每轮入队的任务数
+#define THREADPOOL_BATCH_CHUNK 64
+// parallel_for 自动分块：每个线程平均分到的块数
+#define THREADPOOL_RANGE_CHUNKS_PER_THREAD 8
+// 老化上限：某级别有任务却被更高级别连续越过这么多次后优先服务一次
+#define THREADPOOL_AGING_LIMIT 64
 
-/* 任务结构体 */
+// 任务标志
+#define TASK_FLAG_INLINE 0x1    // 参数存放在任务内联缓冲区中
+
+/* 任务结构体（按值存放在队列槽位中） */
 typedef struct threadpool_task {
     threadpool_task_func function; // 任务函数
-    void *argument;                // 函数参数
+    void *argument;                // 函数参数（内联任务不使用）
+    threadpool_task_func cancel;   // 任务未执行即被丢弃时调用（参数同 function，可为 NULL）
+    unsigned char payload[THREADPOOL_INLINE_SIZE]; // 内联参数缓冲区（紧随三个指针（64位平台偏移24），8字节对齐）
+    uint32_t flags;                // TASK_FLAG_*
+    uint64_t enqueue_ns;           // 提交时间（仅开启 latency_stats 时记录）
+} threadpool_task_t;
+
+// threadpool_add_inline 承诺任务函数收到的指针按8字节对齐，调整字段时不能破坏
+_Static_assert(offsetof(threadpool_task_t, payload) % 8 == 0 && _Alignof(threadpool_task_t) >= 8,
+               "inline payload must be 8-byte aligned");
+
+/* 溢出队列节点：仅在无限制模式下无锁队列已满时才需要分配 */
+typedef struct threadpool_task_node {
+    threadpool_task_t task;        // 任务副本
     // 标记分配来源：1=fixed(size class), 2=pool(general), 3=malloc
     unsigned char alloc_type;
-} threadpool_task_t;
+} threadpool_task_node_t;
+
+/* future 状态位 */
+#define FUTURE_PENDING   0x0    // 尚未完成
+#define FUTURE_READY     0x1    // 已完成，结果可读
+#define FUTURE_CANCELLED 0x2    // 任务被丢弃
+#define FUTURE_DONE_MASK (FUTURE_READY | FUTURE_CANCELLED)
+#define FUTURE_WAITERS   0x4    // 有线程在 futex 上等待，完成方需要唤醒
+
+/* 任务结果句柄（完成状态），从线程池的 task_pool 分配 */
+struct threadpool_future {
+    _Atomic uint32_t state;     // FUTURE_* 状态位，同时作为 futex 字
+    atomic_int refs;            // 引用计数：调用方句柄 + 未完成的任务
+    void *result;               // 任务返回值（state 含 FUTURE_READY 后有效）
+    threadpool_t *pool;         // 所属线程池
+    memory_pool_t *mem;         // 分配来源（提交方所在分区的 task_pool）
+};
+
+/* future 任务的内联参数 */
+typedef struct future_call {
+    threadpool_future_func function;
+    void *argument;
+    threadpool_future_t *future;
+} future_call_t;
+
+_Static_assert(sizeof(future_call_t) <= THREADPOOL_INLINE_SIZE, "future_call_t must fit inline payload");
+
+/* 任务组计数位 */
+#define GROUP_WAITERS    0x80000000u // 有线程在 futex 上等待
+#define GROUP_COUNT_MASK 0x7fffffffu // 未完成任务数
+
+/* 任务组，从线程池的 task_pool 分配 */
+struct threadpool_group {
+    _Atomic uint32_t pending;   // 未完成任务数 | GROUP_WAITERS，同时作为 futex 字
+    atomic_int cancelled;       // 自上次等待以来被丢弃的任务数
+    threadpool_t *pool;         // 所属线程池
+    memory_pool_t *mem;         // 分配来源（栈上的任务组为 NULL）
+};
+
+/* 任务组任务的内联参数 */
+typedef struct group_call {
+    threadpool_task_func function;
+    void *argument;
+    threadpool_group_t *group;
+} group_call_t;
+
+_Static_assert(sizeof(group_call_t) <= THREADPOOL_INLINE_SIZE, "group_call_t must fit inline payload");
+
+/* parallel_for 子区间任务的内联参数 */
+typedef struct range_call {
+    threadpool_range_func function;
+    void *ctx;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    threadpool_group_t *group;  // 调用方栈上的任务组
+} range_call_t;
+
+_Static_assert(sizeof(range_call_t) <= THREADPOOL_INLINE_SIZE, "range_call_t must fit inline payload");
+
+/* 线程池分区：NUMA 模式下每个节点一个，其余模式只有一个 */
+typedef struct threadpool_partition {
+    pthread_mutex_t lock;       // 互斥锁保护本分区溢出队列
+    ring_queue_mpmc_t *queue[THREADPOOL_PRIORITY_LEVELS]; // 各优先级全局任务队列（无锁有界，按值存放任务）
+    ring_queue_t *overflow[THREADPOOL_PRIORITY_LEVELS];   // 各优先级溢出队列（持锁访问，存放节点指针）
+    atomic_int overflow_size[THREADPOOL_PRIORITY_LEVELS]; // 各溢出队列中的任务数量（无锁判断是否需要加锁取任务）
+    memory_pool_t *task_pool;   // 内部对象内存池（溢出节点、future、任务组），NUMA 模式下绑定到本节点
+    int node;                   // NUMA 节点编号（-1 表示不绑定）
+    int index;                  // 分区编号
+} threadpool_partition_t;
+
+/* 外部提交方统计计数槽数量（按线程分散，减少多个提交方写同一缓存行） */
+#define THREADPOOL_STAT_SHARDS 16
+
+/* 统计计数器：独占缓存行，工作线程的计数只由该线程写入，读取时汇总 */
+typedef struct threadpool_counters {
+    _Alignas(64) _Atomic uint64_t submitted; // 提交成功的任务数
+    _Atomic uint64_t rejected;      // 被拒绝的任务数
+    _Atomic uint64_t completed;     // 执行完成的任务数
+    _Atomic uint64_t local_pushes;  // 进入本地队列的任务数
+    _Atomic uint64_t steals;        // 窃取成功次数
+    _Atomic uint64_t alloc_fixed;   // 溢出节点分配路径：固定大小类别
+    _Atomic uint64_t alloc_pool;    // 溢出节点分配路径：内存池通用分配
+    _Atomic uint64_t alloc_malloc;  // 溢出节点分配路径：malloc
+    _Atomic uint64_t busy_ns;       // 已结束的活动时间
+    _Atomic uint64_t idle_ns;       // 已结束的等待时间
+    _Atomic uint64_t active_since;  // 当前活动期开始时间（0 表示不在活动期）
+    _Atomic uint64_t idle_since;    // 当前等待期开始时间（0 表示不在等待期）
+    bool shared;                    // 外部提交方计数槽：可能被多个线程写入，须原子加
+} threadpool_counters_t;
+
+/* 跟踪事件类型（事件参数见 threadpool_trace_dump） */
+#define TRACE_SUBMIT     1      // 提交任务：参数为 数量<<8 | 优先级
+#define TRACE_DEQUEUE    2      // 取得任务：参数为取走后的待执行任务数
+#define TRACE_START      3      // 开始执行：参数为任务函数地址
+#define TRACE_END        4      // 执行结束
+#define TRACE_STEAL      5      // 窃取成功：参数为被窃取的工作线程编号
+#define TRACE_PARK       6      // 进入 futex 休眠
+#define TRACE_UNPARK     7      // 休眠结束
+#define TRACE_WAKE       8      // 发起唤醒：参数为唤醒数量（0 表示全部）
+#define TRACE_LOCK       9      // 开始等待互斥锁（仅锁被占用时记录）
+#define TRACE_LOCKED     10     // 取得互斥锁
+#define TRACE_ALLOC      11     // 开始从内存池分配
+#define TRACE_ALLOC_END  12     // 分配结束
+#define TRACE_SPAWN      13     // 新建工作线程：参数为槽位编号
+#define TRACE_RETIRE     14     // 工作线程退出
+
+#define TRACE_ARG_MASK   ((1ULL << 56) - 1)
+
+/* 跟踪事件：两个字均为原子变量，导出时可与写入并发（最旧的事件可能被覆盖） */
+typedef struct trace_event {
+    _Atomic uint64_t ts;        // 时间戳（x86 上为 TSC 周期，其他平台为纳秒）
+    _Atomic uint64_t info;      // 高 8 位为事件类型，低 56 位为参数
+} trace_event_t;
+
+/* 跟踪缓冲区：环形，写满后覆盖最旧的事件 */
+typedef struct trace_buffer {
+    _Alignas(64) _Atomic uint64_t head; // 已写入的事件总数
+    bool shared;                // 外部提交方共用：用原子加分配位置
+    trace_event_t events[];     // 事件数组（容量为线程池的 trace_capacity）
+} trace_buffer_t;
+
+/* 延迟直方图（对数-线性）：每个2的幂区间分成 2^LATENCY_SUB_BITS 个等宽桶 */
+#define LATENCY_SUB_BITS  4
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS  40    // 不小于 2^40 ns（约18分钟）的值计入最后一个桶
+#define LATENCY_BUCKETS   ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+#define LATENCY_KINDS     2
+
+/* 延迟直方图：只由所属工作线程写入，读取时合并 */
+typedef struct latency_hist {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t min_ns;
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+/* 工作线程槽位状态 */
+#define WORKER_EMPTY   0        // 没有线程（或线程已被 join）
+#define WORKER_RUNNING 1        // 线程运行中
+#define WORKER_EXITED  2        // 线程已退出，等待 join 后槽位可复用
+
+/* 工作线程上下文（槽位），线程数调整时复用 */
+typedef struct threadpool_worker {
+    threadpool_t *pool;         // 所属线程池
+    threadpool_partition_t *part; // 所属分区
+    ws_deque_t *deque;          // 本地工作窃取队列（按值存放 threadpool_task_t），首次使用槽位时创建
+    ring_queue_spsc_t *inbox;   // 定向投递收件箱（存放溢出节点指针，只由本线程取出），与本地队列一同创建
+    atomic_bool inbox_lock;     // 投递方互斥：收件箱只允许一个生产者，一对一投递时没有争用
+    bool inbox_open;            // 是否接受投递（持 inbox_lock 访问），线程启动时打开、退出前关闭
+    atomic_bool parked;         // 正在 futex 休眠，定向投递据此决定是否唤醒
+    atomic_int state;           // 槽位状态（WORKER_*）
+    int index;                  // 工作线程编号
+    unsigned int rng;           // 选择窃取目标的随机数状态
+    unsigned int starve[THREADPOOL_PRIORITY_LEVELS]; // 各级别被越过的次数（老化计数）
+    bool pinned;                // 是否绑定CPU
+    cpu_set_t cpus;             // 绑定的CPU集合
+    threadpool_counters_t stats; // 运行统计（只由该槽位的线程写入）
+    latency_hist_t *latency;    // 排队/执行时间直方图（开启 latency_stats 时首次使用槽位时分配）
+    trace_buffer_t *trace;      // 跟踪缓冲区（开启跟踪时首次使用槽位时分配）
+} threadpool_worker_t;
 
 /* 线程池结构体定义 */
 struct threadpool_t {
-    pthread_mutex_t lock;       // 互斥锁保护任务队列
-    pthread_cond_t notify;      // 条件变量用于任务通知
-    pthread_cond_t empty;       // 条件变量：队列清空并无活跃任务
+    pthread_mutex_t lock;       // 互斥锁保护关闭流程与工作线程的新建/回收
+    _Atomic uint32_t wake_seq;  // 唤醒序号（futex 字），休眠的工作线程在其上等待
     pthread_t *threads;         // 工作线程数组
-    ring_queue_t *queue;        // 任务队列（环形队列）
-    int thread_count;           // 线程数量
-    int started;                // 已成功启动的线程数
-    int queue_size;             // 当前队列中任务数量
+    threadpool_worker_t *workers; // 工作线程上下文数组
+    threadpool_partition_t *partitions; // 分区数组（全局队列与内部内存池）
+    int partition_count;        // 分区数量
+    int *cpu_partition;         // CPU 编号 -> 就近分区（外部线程提交时选择分区），仅多分区时使用
+    int cpu_partition_size;     // cpu_partition 长度
+    int capacity;               // 工作线程槽位数（threads/workers 数组长度）
+    atomic_int thread_count;    // 已使用过的槽位数（只增不减，窃取时遍历的范围）
+    atomic_int started;         // 正在运行的工作线程数
+    atomic_int min_threads;     // 线程数下限（空闲超时退出不低于此数）
+    atomic_int max_threads;     // 线程数上限（负载高时新建不超过此数）
+    bool fixed;                 // 固定线程数：threadpool_resize 同时调整上下限
+    int keepalive_ms;           // 超出下限的线程空闲多久后退出（<=0 不退出）
+    int grow_threshold;         // 没有空闲线程且待执行任务数达到此值时新建线程
+    pthread_attr_t attr;        // 工作线程属性（新建线程时复用，持 lock 访问）
+    char name_prefix[16];       // 线程名前缀（空串表示不命名）
+    atomic_int queue_size;      // 当前待执行任务数量（各分区全局队列 + 溢出队列 + 各本地队列）
+    atomic_int queue_high_water; // 待执行任务数的历史最大值（只在超过时写入）
+    _Atomic uint64_t cancelled; // 未执行即被丢弃的任务数
+    threadpool_counters_t *ext_stats; // 外部提交方统计计数槽（THREADPOOL_STAT_SHARDS 个）
+    bool latency_stats;         // 是否记录任务延迟直方图
+    size_t trace_capacity;      // 每个跟踪缓冲区的事件数（2 的幂，0 表示不跟踪）
+    trace_buffer_t **ext_trace; // 外部提交方跟踪缓冲区（THREADPOOL_STAT_SHARDS 个）
+    uint64_t trace_tsc0;        // 创建时的跟踪时钟读数（导出时换算为微秒）
+    uint64_t trace_ns0;         // 创建时的 CLOCK_MONOTONIC 纳秒
+    atomic_int idle;            // 正在休眠等待的工作线程数
+    atomic_int spinning;        // 正在自旋/让出CPU等待任务的工作线程数
+    threadpool_idle_policy_t idle_policy; // 空闲策略
+    int spin_count;             // 自旋轮数
+    int yield_count;            // 让出CPU轮数
     int max_queue_size;         // 任务队列最大容量（0 表示无限制，将自动扩容）
-    bool shutdown;              // 线程池关闭标志
-    bool shutdown_immediate;    // 立即关闭标志
-    int active;                 // 正在执行的任务数量
+    atomic_bool shutdown;       // 线程池关闭标志
+    atomic_bool shutdown_immediate; // 立即关闭标志
+    atomic_int refs;            // 引用计数：线程池本身 + 未释放的 future/任务组（归零时释放各分区 task_pool）
+
+#ifdef DEBUG
+    // 调试统计
+    size_t dbg_free_pool_fixed;
+    size_t dbg_free_malloc;
+    size_t dbg_destroy_free_pool_fixed;
+#endif
+};
+
+// 当前线程对应的工作线程上下文（非工作线程为 NULL）
+static __thread threadpool_worker_t *tls_worker = NULL;
+
+// 当前线程作为外部提交方使用的统计计数槽（-1 表示尚未分配）
+static __thread int tls_stat_shard = -1;
+static atomic_uint next_stat_shard = 0;
+
+/**
+ * 自旋等待提示：降低功耗并让出超线程的执行资源
+ */
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/**
+ * futex 等待：*addr 仍为 expected 时休眠，deadline 为 CLOCK_MONOTONIC 绝对时间（NULL 表示不限时）
+ */
+static inline long futex_wait(_Atomic uint32_t *addr, uint32_t expected, const struct timespec *deadline)
+{
+    return syscall(SYS_futex, addr, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, expected,
+                   deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+}
+
+/**
+ * 带掩码的 futex 等待：普通唤醒（FUTEX_WAKE）不论掩码都会命中，
+ * futex_wake_bits 只唤醒掩码有交集的等待者
+ */
+static inline long futex_wait_bits(_Atomic uint32_t *addr, uint32_t expected, const struct timespec *deadline,
+                                   uint32_t bits)
+{
+    return syscall(SYS_futex, addr, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, expected,
+                   deadline, NULL, bits);
+}
+
+/**
+ * futex 唤醒最多 count 个等待者
+ */
+static inline void futex_wake(_Atomic uint32_t *addr, int count)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, NULL, NULL, 0);
+}
+
+/**
+ * 唤醒最多 count 个掩码与 bits 有交集的等待者
+ */
+static inline void futex_wake_bits(_Atomic uint32_t *addr, int count, uint32_t bits)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, count, NULL, NULL, bits);
+}
+
+/**
+ * futex 唤醒所有等待者
+ */
+static inline void futex_wake_all(_Atomic uint32_t *addr)
+{
+    futex_wake(addr, INT_MAX);
+}
+
+/**
+ * 计算 ms 毫秒之后的 CLOCK_MONOTONIC 绝对时间
+ */
+static void deadline_after_ms(struct timespec *deadline, long ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += ms / 1000;
+    deadline->tv_nsec += (ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * 当前时间（CLOCK_MONOTONIC 纳秒）
+ */
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * 统计计数累加：工作线程独占的计数器直接读改写，不需要原子读改写指令
+ */
+static inline void counter_add(const threadpool_counters_t *c, _Atomic uint64_t *field, uint64_t n)
+{
+    if (c->shared) {
+        atomic_fetch_add_explicit(field, n, memory_order_relaxed);
+    } else {
+        atomic_store_explicit(field, atomic_load_explicit(field, memory_order_relaxed) + n,
+                              memory_order_relaxed);
+    }
+}
+
+#define STAT_ADD(c, field, n) counter_add((c), &(c)->field, (n))
+
+/**
+ * 当前线程作为外部提交方使用的计数槽/跟踪缓冲区编号
+ */
+static inline int threadpool_shard(void)
+{
+    if (tls_stat_shard < 0) {
+        tls_stat_shard = (int)(atomic_fetch_add_explicit(&next_stat_shard, 1, memory_order_relaxed) %
+                               THREADPOOL_STAT_SHARDS);
+    }
+    return tls_stat_shard;
+}
+
+/**
+ * 当前线程的统计计数器：本线程池的工作线程用自己的，其他线程按线程分散到计数槽
+ */
+static inline threadpool_counters_t *threadpool_counters(threadpool_t *pool)
+{
+    threadpool_worker_t *self = tls_worker;
+
+    if (self != NULL && self->pool == pool) {
+        return &self->stats;
+    }
+    return &pool->ext_stats[threadpool_shard()];
+}
+
+/**
+ * 跟踪时钟：x86 上直接读 TSC（约几十个周期），其他平台使用 CLOCK_MONOTONIC
+ */
+static inline uint64_t trace_clock(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return now_ns();
+#endif
+}
+
+/**
+ * 写入一个跟踪事件：独占缓冲区只由所属线程写入，共用缓冲区原子分配位置
+ */
+static void trace_write(threadpool_t *pool, trace_buffer_t *b, int type, uint64_t arg)
+{
+    uint64_t i;
+
+    if (b->shared) {
+        i = atomic_fetch_add_explicit(&b->head, 1, memory_order_relaxed);
+    } else {
+        i = atomic_load_explicit(&b->head, memory_order_relaxed);
+    }
+    trace_event_t *e = &b->events[i & (pool->trace_capacity - 1)];
+    atomic_store_explicit(&e->ts, trace_clock(), memory_order_relaxed);
+    atomic_store_explicit(&e->info, ((uint64_t)type << 56) | (arg & TRACE_ARG_MASK), memory_order_release);
+    if (!b->shared) {
+        atomic_store_explicit(&b->head, i + 1, memory_order_release);
+    }
+}
+
+/**
+ * 当前线程的跟踪缓冲区
+ */
+static inline trace_buffer_t *threadpool_trace_buffer(threadpool_t *pool)
+{
+    threadpool_worker_t *self = tls_worker;
+
+    if (self != NULL && self->pool == pool) {
+        return self->trace;
+    }
+    return pool->ext_trace[threadpool_shard()];
+}
+
+// 记录跟踪事件；未开启跟踪时只有一次判断
+#define TRACE(pool, type, arg) do { \
+        if ((pool)->trace_capacity) { \
+            trace_write((pool), threadpool_trace_buffer(pool), (type), (uint64_t)(arg)); \
+        } \
+    } while (0)
+
+// 已知当前工作线程时直接写入其缓冲区
+#define TRACE_SELF(pool, self, type, arg) do { \
+        if ((pool)->trace_capacity) { \
+            trace_write((pool), (self)->trace, (type), (uint64_t)(arg)); \
+        } \
+    } while (0)
+
+/**
+ * 加锁：开启跟踪时记录锁被占用、需要等待的区间
+ */
+static int threadpool_mutex_lock(threadpool_t *pool, pthread_mutex_t *mutex)
+{
+    if (pool->trace_capacity == 0) {
+        return pthread_mutex_lock(mutex);
+    }
+    if (pthread_mutex_trylock(mutex) == 0) {
+        return 0;
+    }
+    TRACE(pool, TRACE_LOCK, 0);
+    int rc = pthread_mutex_lock(mutex);
+    TRACE(pool, TRACE_LOCKED, 0);
+    return rc;
+}
+
+/**
+ * 记录待执行任务数，超过历史最大值时更新
+ */
+static inline void threadpool_note_depth(threadpool_t *pool, int depth)
+{
+    int hw = atomic_load_explicit(&pool->queue_high_water, memory_order_relaxed);
+    while (depth > hw &&
+           !atomic_compare_exchange_weak_explicit(&pool->queue_high_water, &hw, depth,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+/**
+ * 延迟值所在的直方图桶：小于 LATENCY_SUB_COUNT 的值各占一个桶，
+ * 更大的值按最高位所在区间分组，组内取最高位之后的 LATENCY_SUB_BITS 位
+ */
+static inline int latency_index(uint64_t v)
+{
+    if (v < LATENCY_SUB_COUNT) {
+        return (int)v;
+    }
+    int msb = 63 - __builtin_clzll(v);
+    if (msb >= LATENCY_MAX_BITS) {
+        return LATENCY_BUCKETS - 1;
+    }
+    int shift = msb - LATENCY_SUB_BITS;
+    return (shift + 1) * LATENCY_SUB_COUNT + (int)((v >> shift) & (LATENCY_SUB_COUNT - 1));
+}
+
+/**
+ * 直方图桶可表示的最大值
+ */
+static uint64_t latency_upper(int index)
+{
+    if (index < LATENCY_SUB_COUNT) {
+        return (uint64_t)index;
+    }
+    int shift = index / LATENCY_SUB_COUNT - 1;
+    uint64_t sub = (uint64_t)(index % LATENCY_SUB_COUNT);
+    return ((LATENCY_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+/**
+ * 记录一个延迟样本（只由所属工作线程调用，不需要原子读改写）
+ */
+static inline void latency_record(latency_hist_t *h, uint64_t v)
+{
+    _Atomic uint64_t *bucket = &h->buckets[latency_index(v)];
+    uint64_t count = atomic_load_explicit(&h->count, memory_order_relaxed);
+
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_store_explicit(&h->sum_ns, atomic_load_explicit(&h->sum_ns, memory_order_relaxed) + v,
+                          memory_order_relaxed);
+    if (count == 0 || v < atomic_load_explicit(&h->min_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&h->min_ns, v, memory_order_relaxed);
+    }
+    if (v > atomic_load_explicit(&h->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&h->max_ns, v, memory_order_relaxed);
+    }
+    atomic_store_explicit(&h->count, count + 1, memory_order_relaxed);
+}
+
+/**
+ * 分配溢出节点：优先固定大小类别，其次内存池通用分配，最后 malloc
+ */
+static threadpool_task_node_t *task_node_alloc(threadpool_t *pool, threadpool_partition_t *part)
+{
+    threadpool_task_node_t *node;
+
+    if (part->task_pool) {
+        node = (threadpool_task_node_t *)memory_pool_alloc_fixed(part->task_pool, sizeof(threadpool_task_node_t));
+        if (node) {
+            node->alloc_type = 1;
+            STAT_ADD(threadpool_counters(pool), alloc_fixed, 1);
+            return node;
+        }
+        // 内存池不足时回退到通用分配，再不行则malloc
+        node = (threadpool_task_node_t *)memory_pool_alloc(part->task_pool, sizeof(threadpool_task_node_t));
+        if (node) {
+            node->alloc_type = 2;
+            STAT_ADD(threadpool_counters(pool), alloc_pool, 1);
+            return node;
+        }
+    }
+    node = (threadpool_task_node_t *)malloc(sizeof(threadpool_task_node_t));
+    if (node) {
+        node->alloc_type = 3;
+        STAT_ADD(threadpool_counters(pool), alloc_malloc, 1);
+    }
+    return node;
+}
+
+/**
+ * 按分配来源释放溢出节点（节点总是从其所在分区的 task_pool 分配）
+ */
+static void task_node_free(threadpool_t *pool, threadpool_partition_t *part, threadpool_task_node_t *node)
+{
+    if (part->task_pool) {
+        switch (node->alloc_type) {
+            case 1: // fixed size class
+                memory_pool_free_fixed(part->task_pool, node);
+#ifdef DEBUG
+                pool->dbg_free_pool_fixed++;
+#endif
+                return;
+            case 2: // general pool
+                memory_pool_free(part->task_pool, node);
+#ifdef DEBUG
+                pool->dbg_free_pool_fixed++; // 统计为来自内存池的释放
+#endif
+                return;
+            default: // 3 or others -> malloc
+                break;
+        }
+    }
+    free(node);
+#ifdef DEBUG
+    pool->dbg_free_malloc++;
+#else
+    (void)pool;
+#endif
+}
+
+/**
+ * 执行任务：内联任务的参数指向执行方自己的任务副本
+ */
+static inline void task_run(threadpool_task_t *task)
+{
+    void *arg = (task->flags & TASK_FLAG_INLINE) ? (void *)task->payload : task->argument;
+    (*(task->function))(arg);
+}
+
+/**
+ * 丢弃未执行的任务：有取消回调时通知任务所有者
+ */
+static inline void task_cancel(threadpool_t *pool, threadpool_task_t *task)
+{
+    if (task->cancel) {
+        void *arg = (task->flags & TASK_FLAG_INLINE) ? (void *)task->payload : task->argument;
+        (*(task->cancel))(arg);
+    }
+    atomic_fetch_add_explicit(&pool->cancelled, 1, memory_order_relaxed);
+}
+
+/**
+ * 释放线程池的一个引用，最后一个引用负责释放内部内存池与结构体本身
+ */
+static void threadpool_release(threadpool_t *pool)
+{
+    if (atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_acq_rel) == 1) {
+        for (int i = 0; i < pool->partition_count; i++) {
+            if (pool->partitions[i].task_pool) {
+                memory_pool_destroy(pool->partitions[i].task_pool);
+            }
+        }
+        free(pool->partitions);
+        free(pool);
+    }
+}
+
+/**
+ * 当前线程就近的分区：工作线程用自己的分区，外部线程按所在CPU的NUMA节点选择
+ */
+static threadpool_partition_t *threadpool_local_partition(threadpool_t *pool)
+{
+    threadpool_worker_t *self = tls_worker;
+
+    if (self != NULL && self->pool == pool) {
+        return self->part;
+    }
+    if (pool->partition_count > 1) {
+        int cpu = sched_getcpu();
+        if (cpu >= 0 && cpu < pool->cpu_partition_size) {
+            return &pool->partitions[pool->cpu_partition[cpu]];
+        }
+    }
+    return &pool->partitions[0];
+}
+
+static void threadpool_grow(threadpool_t *pool);
+
+/**
+ * 为 count 个新任务唤醒休眠的工作线程
+ *
+ * 正在自旋的工作线程会自己发现新任务，只为超出自旋线程数的部分发起唤醒；
+ * 没有线程休眠时完全不进入内核。
+ *
+ * 提交方先增加 queue_size 再读取 spinning/idle，工作线程先减少 spinning、
+ * 增加 idle 再读取 queue_size，均为顺序一致的原子操作，因此至少一方能看到
+ * 对方的写入，不会丢失唤醒。
+ */
+static void threadpool_wake(threadpool_t *pool, int count)
+{
+    count -= atomic_load(&pool->spinning);
+    if (count <= 0) {
+        return;
+    }
+    if (atomic_load(&pool->idle) == 0) {
+        // 没有可唤醒的线程：动态线程池在积压时新建线程
+        if (atomic_load_explicit(&pool->started, memory_order_relaxed) <
+            atomic_load_explicit(&pool->max_threads, memory_order_relaxed)) {
+            threadpool_grow(pool);
+        }
+        return;
+    }
+
+    // 先改变 futex 字，使读取旧值后尚未进入 futex_wait 的线程不会睡下去
+    TRACE(pool, TRACE_WAKE, count);
+    atomic_fetch_add(&pool->wake_seq, 1);
+    futex_wake(&pool->wake_seq, count);
+}
+
+/**
+ * 唤醒所有休眠的工作线程（关闭时使用）
+ */
+static void threadpool_wake_all(threadpool_t *pool)
+{
+    atomic_fetch_add(&pool->wake_seq, 1);
+    futex_wake_all(&pool->wake_seq);
+}
+
+/**
+ * 从分区指定优先级的全局队列取出一个任务：先无锁队列，再溢出队列（需加锁）
+ */
+static bool threadpool_take_level(threadpool_t *pool, threadpool_partition_t *part, int level,
+                                  threadpool_task_t *task)
+{
+    if (part->queue[level] && ring_queue_mpmc_dequeue(part->queue[level], task) == RING_QUEUE_SUCCESS) {
+        return true;
+    }
+
+    // 无锁快速判断，避免溢出队列为空时争用分区锁
+    if (atomic_load_explicit(&part->overflow_size[level], memory_order_acquire) == 0) {
+        return false;
+    }
+
+    threadpool_task_node_t *node = NULL;
+    threadpool_mutex_lock(pool, &(part->lock));
+    void *elem = NULL;
+    if (ring_queue_peek(part->overflow[level], &elem) == RING_QUEUE_SUCCESS && elem != NULL) {
+        // 先从队列移除，避免被其他线程重复获取
+        if (ring_queue_dequeue(part->overflow[level]) == RING_QUEUE_SUCCESS) {
+            node = (threadpool_task_node_t *)elem;
+            atomic_fetch_sub(&part->overflow_size[level], 1);
+        }
+    }
+    pthread_mutex_unlock(&(part->lock));
+
+    if (node == NULL) {
+        return false;
+    }
+    *task = node->task;
+    task_node_free(pool, part, node);
+    return true;
+}
+
+/**
+ * 从分区 [first, last) 级别的全局队列中按优先级从高到低取出一个任务
+ */
+static bool threadpool_take_global(threadpool_t *pool, threadpool_partition_t *part, int first, int last,
+                                   threadpool_task_t *task, int *level)
+{
+    for (int l = first; l < last; l++) {
+        if (threadpool_take_level(pool, part, l, task)) {
+            *level = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 分区指定级别的全局队列中是否有任务（无锁近似判断）
+ */
+static inline bool threadpool_level_pending(threadpool_partition_t *part, int level)
+{
+    return (part->queue[level] && !ring_queue_mpmc_is_empty(part->queue[level])) ||
+           atomic_load_explicit(&part->overflow_size[level], memory_order_relaxed) > 0;
+}
+
+/**
+ * 任务进入分区指定优先级的全局队列：无锁队列已满时（仅无限制模式）进入可扩容的溢出队列；
+ * 加锁队列实现下直接进入溢出队列
+ *
+ * 不负责唤醒工作线程，返回实际入队数量。
+ */
+static int threadpool_push_partition(threadpool_t *pool, threadpool_partition_t *part, int level,
+                                     const threadpool_task_t *tasks, int count)
+{
+    ring_queue_t *overflow = part->overflow[level];
+    int done = 0;
+    if (part->queue[level]) {
+        done = (int)ring_queue_mpmc_enqueue_bulk(part->queue[level], tasks, (size_t)count);
+    }
+    if (done == count || overflow == NULL) {
+        return done;
+    }
+
+    // 剩余任务在一次加锁内进入溢出队列
+    if (threadpool_mutex_lock(pool, &(part->lock)) != 0) {
+        return done;
+    }
+    int spilled = 0;
+    while (done < count) {
+        TRACE(pool, TRACE_ALLOC, 0);
+        threadpool_task_node_t *node = task_node_alloc(pool, part);
+        TRACE(pool, TRACE_ALLOC_END, 0);
+        if (node == NULL) {
+            break;
+        }
+        node->task = tasks[done];
+        // 入队，如果容量不足，尝试扩容
+        if (ring_queue_is_full(overflow)) {
+            size_t new_cap = ring_queue_capacity(overflow) * 2;
+            if (new_cap == 0) new_cap = 1024;
+            ring_queue_resize(overflow, new_cap);
+        }
+        if (ring_queue_is_full(overflow) ||
+            ring_queue_enqueue(overflow, node) != RING_QUEUE_SUCCESS) {
+            // 扩容失败（或极端情况下的失败）
+            task_node_free(pool, part, node);
+            break;
+        }
+        done++;
+        spilled++;
+    }
+    atomic_fetch_add_explicit(&part->overflow_size[level], spilled, memory_order_release);
+    pthread_mutex_unlock(&(part->lock));
+
+    return done;
+}
+
+/**
+ * 任务进入全局队列：优先当前线程就近的分区，有队列上限且该分区已满时依次尝试其他分区
+ *
+ * 不负责唤醒工作线程，返回实际入队数量。
+ */
+static int threadpool_push_global(threadpool_t *pool, int level, const threadpool_task_t *tasks, int count)
+{
+    threadpool_partition_t *part = threadpool_local_partition(pool);
+    int done = threadpool_push_partition(pool, part, level, tasks, count);
+
+    for (int i = 1; done < count && i < pool->partition_count; i++) {
+        threadpool_partition_t *other = &pool->partitions[(part->index + i) % pool->partition_count];
+        done += threadpool_push_partition(pool, other, level, tasks + done, count - done);
+    }
+    return done;
+}
+
+/**
+ * 任务压入当前工作线程的本地队列，返回实际入队数量
+ */
+static int threadpool_push_local(threadpool_worker_t *self, const threadpool_task_t *tasks, int count)
+{
+    int done = 0;
+    while (done < count && ws_deque_push(self->deque, &tasks[done]) == WS_DEQUE_SUCCESS) {
+        done++;
+    }
+    STAT_ADD(&self->stats, local_pushes, (uint64_t)done);
+    return done;
+}
+
+/**
+ * 从其他工作线程的本地队列随机窃取一个任务
+ *
+ * same_part 为 true 时只窃取同一分区的工作线程，否则只窃取其他分区的工作线程。
+ */
+static bool threadpool_steal(threadpool_t *pool, threadpool_worker_t *self, threadpool_task_t *task,
+                             bool same_part)
+{
+    int n = atomic_load_explicit(&pool->thread_count, memory_order_acquire);
+    if (n <= 1) {
+        return false;
+    }
+
+    // xorshift 选择随机起点，依次尝试所有其他工作线程
+    unsigned int x = self->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    self->rng = x;
+
+    int start = (int)(x % (unsigned int)n);
+    for (int i = 0; i < n; i++) {
+        threadpool_worker_t *victim = &pool->workers[(start + i) % n];
+        if (victim == self || (victim->part == self->part) != same_part) {
+            continue;
+        }
+        ws_deque_status_t st;
+        do {
+            st = ws_deque_steal(victim->deque, task);
+        } while (st == WS_DEQUE_ABORT);
+        if (st == WS_DEQUE_SUCCESS) {
+            STAT_ADD(&self->stats, steals, 1);
+            TRACE_SELF(pool, self, TRACE_STEAL, victim->index);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 记录一次从 level 级别取得任务：更低级别中仍有任务的记为被越过一次
+ */
+static void threadpool_age(threadpool_worker_t *self, int level)
+{
+    self->starve[level] = 0;
+    for (int l = level + 1; l < THREADPOOL_PRIORITY_LEVELS; l++) {
+        if (threadpool_level_pending(self->part, l)) {
+            self->starve[l]++;
+        } else {
+            self->starve[l] = 0;
+        }
+    }
+}
+
+/**
+ * 按优先级查找任务
+ *
+ * 顺序：老化到期的低级别 -> 高于普通级别的全局队列 -> 普通级别（本地队列 ->
+ * 全局队列 -> 窃取）-> 低于普通级别的全局队列。本地队列与窃取得到的都是
+ * 普通级别任务。老化计数按工作线程各自维护，不引入共享写。
+ *
+ * 以上只访问本分区；本分区没有任务时才从其他分区的全局队列与工作线程取任务，
+ * 使任务尽量留在提交方所在的 NUMA 节点上执行。
+ */
+static bool threadpool_find_task(threadpool_t *pool, threadpool_worker_t *self, threadpool_task_t *task)
+{
+    threadpool_partition_t *part = self->part;
+    int level;
+
+    // 老化：被越过次数达到上限的级别先服务一次，防止饥饿
+    for (level = THREADPOOL_PRIORITY_LEVELS - 1; level > 0; level--) {
+        if (self->starve[level] >= THREADPOOL_AGING_LIMIT) {
+            self->starve[level] = 0;
+            if (threadpool_take_level(pool, part, level, task)) {
+                threadpool_age(self, level);
+                return true;
+            }
+        }
+    }
+
+    if (threadpool_take_global(pool, part, 0, THREADPOOL_PRIORITY_NORMAL, task, &level)) {
+        threadpool_age(self, level);
+        return true;
+    }
+
+    if (ws_deque_pop(self->deque, task) == WS_DEQUE_SUCCESS ||
+        threadpool_take_level(pool, part, THREADPOOL_PRIORITY_NORMAL, task) ||
+        threadpool_steal(pool, self, task, true)) {
+        threadpool_age(self, THREADPOOL_PRIORITY_NORMAL);
+        return true;
+    }
+
+    if (threadpool_take_global(pool, part, THREADPOOL_PRIORITY_NORMAL + 1, THREADPOOL_PRIORITY_LEVELS,
+                               task, &level)) {
+        threadpool_age(self, level);
+        return true;
+    }
+
+    if (pool->partition_count == 1) {
+        return false;
+    }
+    for (int i = 1; i < pool->partition_count; i++) {
+        threadpool_partition_t *other = &pool->partitions[(part->index + i) % pool->partition_count];
+        if (threadpool_take_global(pool, other, 0, THREADPOOL_PRIORITY_LEVELS, task, &level)) {
+            return true;
+        }
+    }
+    return threadpool_steal(pool, self, task, false);
+}
+
+/**
+ * 工作线程在 futex 上等待时使用的掩码位（定向唤醒用，编号相隔 32 的线程共用一位）
+ */
+static inline uint32_t worker_wake_bit(const threadpool_worker_t *w)
+{
+    return 1u << (w->index % 32);
+}
+
+/**
+ * 收件箱中是否有定向投递的任务
+ */
+static inline bool worker_inbox_pending(const threadpool_worker_t *self)
+{
+    return ring_queue_spsc_size(self->inbox) > 0;
+}
+
+/**
+ * 取得收件箱投递方锁（只在多个提交方同时投递给同一线程时自旋）
+ */
+static inline void worker_inbox_lock(threadpool_worker_t *w)
+{
+    while (atomic_exchange_explicit(&w->inbox_lock, true, memory_order_acquire)) {
+        cpu_relax();
+    }
+}
+
+static inline void worker_inbox_unlock(threadpool_worker_t *w)
+{
+    atomic_store_explicit(&w->inbox_lock, false, memory_order_release);
+}
+
+/**
+ * 打开/关闭收件箱：槽位启动线程前打开，线程退出前关闭
+ */
+static void worker_inbox_set_open(threadpool_worker_t *w, bool open)
+{
+    worker_inbox_lock(w);
+    w->inbox_open = open;
+    worker_inbox_unlock(w);
+}
+
+/**
+ * 从本线程的收件箱取出一个定向投递的任务（收件箱任务不计入 queue_size）
+ */
+static bool threadpool_take_inbox(threadpool_t *pool, threadpool_worker_t *self, threadpool_task_t *task)
+{
+    void *elem = NULL;
+
+    if (ring_queue_spsc_dequeue(self->inbox, &elem) != RING_QUEUE_SUCCESS) {
+        return false;
+    }
+    threadpool_task_node_t *node = (threadpool_task_node_t *)elem;
+    *task = node->task;
+    task_node_free(pool, self->part, node);
+    return true;
+}
+
+/**
+ * 查找并执行一个任务，没有可执行的任务返回 false
+ *
+ * 定向投递给本线程的任务最先执行，其次按 threadpool_find_task 的顺序查找。
+ */
+static bool threadpool_run_one(threadpool_t *pool, threadpool_worker_t *self)
+{
+    threadpool_task_t task;
+
+    if (threadpool_take_inbox(pool, self, &task)) {
+        TRACE_SELF(pool, self, TRACE_DEQUEUE, atomic_load_explicit(&pool->queue_size, memory_order_relaxed));
+    } else if (threadpool_find_task(pool, self, &task)) {
+        int pending = atomic_fetch_sub(&pool->queue_size, 1) - 1;
+        TRACE_SELF(pool, self, TRACE_DEQUEUE, pending);
+
+        // 动态线程池：取走任务后仍有积压且没有空闲线程，说明现有线程处理不过来。
+        // 提交方只在提交时判断，积压期间由工作线程补充新建
+        if (atomic_load_explicit(&pool->started, memory_order_relaxed) <
+            atomic_load_explicit(&pool->max_threads, memory_order_relaxed) &&
+            pending >= pool->grow_threshold &&
+            atomic_load(&pool->idle) == 0 && atomic_load(&pool->spinning) == 0) {
+            threadpool_grow(pool);
+        }
+    } else {
+        return false;
+    }
+    // 执行任务（任务已按值拷贝到本地，无需释放）
+    TRACE_SELF(pool, self, TRACE_START, (uintptr_t)task.function);
+    if (pool->latency_stats) {
+        uint64_t start = now_ns();
+        task_run(&task);
+        uint64_t end = now_ns();
+        latency_record(&self->latency[THREADPOOL_LATENCY_WAIT],
+                       start > task.enqueue_ns ? start - task.enqueue_ns : 0);
+        latency_record(&self->latency[THREADPOOL_LATENCY_RUN], end - start);
+    } else {
+        task_run(&task);
+    }
+    TRACE_SELF(pool, self, TRACE_END, 0);
+    STAT_ADD(&self->stats, completed, 1);
+    return true;
+}
+
+/**
+ * 等待期间协助执行：调用方是本线程池的工作线程时代为执行一个任务
+ *
+ * 返回 true 表示执行了任务（或有任务已计数尚未发布，已让出CPU），调用方
+ * 应重新检查等待条件；返回 false 表示调用方可以阻塞：所有已接受的任务都
+ * 已被其他线程取走执行，完成后会唤醒等待者，因此在工作线程内部等待不会
+ * 因占住线程而死锁。
+ */
+static bool threadpool_help(threadpool_t *pool)
+{
+    threadpool_worker_t *self = tls_worker;
+
+    if (self == NULL || self->pool != pool) {
+        return false;
+    }
+    if (threadpool_run_one(pool, self)) {
+        return true;
+    }
+    if (atomic_load(&pool->queue_size) > 0) {
+        sched_yield();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * 工作线程空闲等待：自旋 -> 让出CPU -> futex 休眠
+ *
+ * 自旋阶段计入 spinning，提交方据此省去唤醒系统调用。自旋中发现任务时，
+ * 若还有其他待执行任务，则代为唤醒一个线程，避免多个任务只被一个自旋线程
+ * 逐个处理。返回后由调用方重新查找任务。
+ *
+ * 线程数高于下限时限时休眠，返回 true 表示休眠超时，调用方可以退出线程。
+ */
+static bool threadpool_idle(threadpool_t *pool, threadpool_worker_t *self)
+{
+    int rounds = pool->spin_count + pool->yield_count;
+    bool timed_out = false;
+
+    // 活动期结束、等待期开始（每次空闲只读两次时钟）
+    uint64_t t = now_ns();
+    STAT_ADD(&self->stats, busy_ns, t - atomic_load_explicit(&self->stats.active_since, memory_order_relaxed));
+    atomic_store_explicit(&self->stats.active_since, 0, memory_order_relaxed);
+    atomic_store_explicit(&self->stats.idle_since, t, memory_order_relaxed);
+
+    if (rounds > 0) {
+        int i;
+        atomic_fetch_add(&pool->spinning, 1);
+        for (i = 0; i < rounds; i++) {
+            if (atomic_load_explicit(&pool->queue_size, memory_order_relaxed) > 0 ||
+                worker_inbox_pending(self) ||
+                atomic_load_explicit(&pool->shutdown, memory_order_relaxed)) {
+                break;
+            }
+            if (i < pool->spin_count) {
+                cpu_relax();
+            } else {
+                sched_yield();
+            }
+        }
+        atomic_fetch_sub(&pool->spinning, 1);
+
+        if (i < rounds) {
+            if (atomic_load(&pool->queue_size) > 1) {
+                threadpool_wake(pool, 1);
+            }
+            goto out;
+        }
+        if (pool->idle_policy == THREADPOOL_IDLE_SPIN) {
+            goto out;
+        }
+    }
+
+    struct timespec deadline;
+    const struct timespec *timeout = NULL;
+    if (pool->keepalive_ms > 0 &&
+        atomic_load_explicit(&pool->started, memory_order_relaxed) >
+        atomic_load_explicit(&pool->min_threads, memory_order_relaxed)) {
+        deadline_after_ms(&deadline, pool->keepalive_ms);
+        timeout = &deadline;
+    }
+
+    // 休眠：先读取唤醒序号再登记 idle/parked 并复查任务计数与收件箱，
+    // 复查之后到 futex_wait 之间的唤醒会因序号变化而立即返回
+    uint32_t seq = atomic_load(&pool->wake_seq);
+    atomic_fetch_add(&pool->idle, 1);
+    atomic_store(&self->parked, true);
+    atomic_thread_fence(memory_order_seq_cst); // 与 threadpool_add_to 入队后、读取 parked 前的屏障配对
+    if (atomic_load(&pool->queue_size) == 0 && !worker_inbox_pending(self) && !atomic_load(&pool->shutdown)) {
+        TRACE_SELF(pool, self, TRACE_PARK, 0);
+        timed_out = futex_wait_bits(&pool->wake_seq, seq, timeout, worker_wake_bit(self)) != 0 &&
+                    errno == ETIMEDOUT;
+        TRACE_SELF(pool, self, TRACE_UNPARK, 0);
+    }
+    atomic_store(&self->parked, false);
+    atomic_fetch_sub(&pool->idle, 1);
+
+out:
+    t = now_ns();
+    STAT_ADD(&self->stats, idle_ns, t - atomic_load_explicit(&self->stats.idle_since, memory_order_relaxed));
+    atomic_store_explicit(&self->stats.idle_since, 0, memory_order_relaxed);
+    atomic_store_explicit(&self->stats.active_since, t, memory_order_relaxed);
+    return timed_out;
+}
+
+/**
+ * 运行中的线程数高于 floor 时登记本线程退出
+ *
+ * 登记在减少 idle 之后，与提交方“先计数再读 idle”配对：提交方若看不到空闲
+ * 线程就会新建线程或由忙碌的线程稍后取走任务；这里再复查一次任务计数，
+ * 有任务时转交给其他线程，已接受的任务不会因本线程退出而滞留。
+ */
+static bool threadpool_retire(threadpool_t *pool, int floor)
+{
+    int n = atomic_load(&pool->started);
+
+    while (n > floor) {
+        if (atomic_compare_exchange_weak(&pool->started, &n, n - 1)) {
+            TRACE(pool, TRACE_RETIRE, 0);
+            if (atomic_load(&pool->queue_size) > 0) {
+                threadpool_wake(pool, 1);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * 关闭收件箱并处理剩余的定向任务：立即关闭时取消，否则由本线程执行完
+ *
+ * 关闭在投递方锁内完成，此后的投递都会被拒绝，因此退出前已被接受的定向
+ * 任务不会滞留。
+ */
+static void threadpool_close_inbox(threadpool_t *pool, threadpool_worker_t *self)
+{
+    threadpool_task_t task;
+
+    worker_inbox_set_open(self, false);
+    while (threadpool_take_inbox(pool, self, &task)) {
+        if (atomic_load(&pool->shutdown_immediate)) {
+            task_cancel(pool, &task);
+        } else {
+            task_run(&task);
+            STAT_ADD(&self->stats, completed, 1);
+        }
+    }
+}
+
+/**
+ * 工作线程函数
+ */
+static void *threadpool_worker(void *arg)
+{
+    threadpool_worker_t *self = (threadpool_worker_t *)arg;
+    threadpool_t *pool = self->pool;
+
+    tls_worker = self;
+    atomic_store_explicit(&self->stats.active_since, now_ns(), memory_order_relaxed);
+
+    while (1) {
+        // 立即关闭时不再取新任务
+        if (atomic_load(&pool->shutdown_immediate)) {
+            break;
+        }
+
+        // 线程数超过上限（threadpool_resize 调小）时，本地队列为空的线程退出
+        if (atomic_load_explicit(&pool->started, memory_order_relaxed) >
+            atomic_load_explicit(&pool->max_threads, memory_order_relaxed) &&
+            ws_deque_is_empty(self->deque) &&
+            threadpool_retire(pool, atomic_load(&pool->max_threads))) {
+            break;
+        }
+
+        if (threadpool_run_one(pool, self)) {
+            continue;
+        }
+
+        // 先读关闭标志再读任务计数：与提交方“先计数再检查关闭”配对，
+        // 保证优雅关闭前已被接受的任务一定会被执行
+        bool shutting_down = atomic_load(&pool->shutdown);
+
+        // 任务已计数但尚未发布到队列（提交方正在入队），让出CPU后重试
+        if (atomic_load(&pool->queue_size) > 0) {
+            sched_yield();
+            continue;
+        }
+
+        // 优雅关闭并且所有任务都已取走，则退出
+        if (shutting_down) {
+            break;
+        }
+
+        // 按空闲策略等待任务或关闭信号；超出下限的线程空闲超时后退出
+        if (threadpool_idle(pool, self) && threadpool_retire(pool, atomic_load(&pool->min_threads))) {
+            break;
+        }
+    }
+
+    threadpool_close_inbox(pool, self);
+
+    STAT_ADD(&self->stats, busy_ns,
+             now_ns() - atomic_load_explicit(&self->stats.active_since, memory_order_relaxed));
+    atomic_store_explicit(&self->stats.active_since, 0, memory_order_relaxed);
+    tls_worker = NULL;
+    // 最后一步：此后线程不再访问线程池，槽位可被 join 后复用
+    atomic_store(&self->state, WORKER_EXITED);
+    return NULL;
+}
+
+/**
+ * 用默认值填充线程池配置
+ */
+void threadpool_config_default(threadpool_config_t *config)
+{
+    if (config == NULL) {
+        return;
+    }
+    memset(config, 0, sizeof(*config));
+    config->thread_count = 4;
+    config->min_threads = 0;
+    config->max_threads = 0;
+    config->keepalive_ms = THREADPOOL_DEFAULT_KEEPALIVE_MS;
+    config->grow_threshold = THREADPOOL_DEFAULT_GROW_THRESHOLD;
+    config->queue_size = 0;
+    config->queue_impl = THREADPOOL_QUEUE_LOCKFREE;
+    config->queue_capacity = THREADPOOL_DEFAULT_QUEUE_CAPACITY;
+    config->task_pool_size = 0;
+    config->task_pool_alignment = THREADPOOL_DEFAULT_TASK_POOL_ALIGNMENT;
+    config->future_prealloc = THREADPOOL_DEFAULT_FUTURE_PREALLOC;
+    config->overflow_prealloc = 0;
+    config->idle_policy = THREADPOOL_IDLE_ADAPTIVE;
+    config->spin_count = THREADPOOL_DEFAULT_SPIN_COUNT;
+    config->yield_count = THREADPOOL_DEFAULT_YIELD_COUNT;
+    config->stack_size = 0;
+    config->guard_size = 0;
+    config->cpu_list = NULL;
+    config->cpu_count = 0;
+    config->name_prefix = NULL;
+}
+
+/**
+ * 创建线程池
+ */
+threadpool_t *threadpool_create(int thread_count, int queue_size)
+{
+    threadpool_config_t config;
+
+    threadpool_config_default(&config);
+    config.thread_count = thread_count;
+    config.queue_size = queue_size;
+
+    return threadpool_create_with_config(&config);
+}
+
+/**
+ * 按配置设置工作线程属性：栈大小、保护区大小（CPU亲和性按线程单独设置）
+ */
+static int threadpool_init_attr(pthread_attr_t *attr, const threadpool_config_t *config)
+{
+    if (pthread_attr_init(attr) != 0) {
+        return -1;
+    }
+    if ((config->stack_size > 0 && pthread_attr_setstacksize(attr, config->stack_size) != 0) ||
+        (config->guard_size > 0 && pthread_attr_setguardsize(attr, config->guard_size) != 0)) {
+        pthread_attr_destroy(attr);
+        return -1;
+    }
+    return 0;
+}
+
+/* 候选CPU拓扑：按 (NUMA节点, CPU编号) 排序并按节点分组 */
+typedef struct threadpool_topology {
+    int *node_of;               // CPU编号 -> NUMA节点（长度 CPU_SETSIZE，未知为0）
+    int *cpus;                  // 排序后的候选CPU
+    int cpu_count;              // 候选CPU数量
+    int *node_id;               // 各分组的节点编号
+    int *node_first;            // 各分组在 cpus 中的起始下标
+    int *node_len;              // 各分组的CPU数量
+    int node_count;             // 候选CPU涉及的节点数
+} threadpool_topology_t;
+
+/**
+ * 解析 sysfs cpulist 格式（如 "0-3,8-11"），将其中的CPU记为属于 node
+ */
+static void topology_parse_cpulist(const char *s, int node, int *node_of)
+{
+    while (*s != '\0') {
+        char *end;
+        long lo = strtol(s, &end, 10);
+        if (end == s) {
+            break;
+        }
+        long hi = lo;
+        s = end;
+        if (*s == '-') {
+            hi = strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long c = (lo < 0 ? 0 : lo); c <= hi && c < CPU_SETSIZE; c++) {
+            node_of[c] = node;
+        }
+        if (*s != ',') {
+            break;
+        }
+        s++;
+    }
+}
+
+/**
+ * 读取 /sys/devices/system/node/node<N>/cpulist 建立CPU到节点的映射
+ *
+ * 没有 sysfs NUMA 信息（非NUMA内核、容器限制）时所有CPU视为节点0。
+ */
+static void topology_read_nodes(int *node_of)
+{
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        int node;
+        char path[320], buf[4096];
+        if (sscanf(ent->d_name, "node%d", &node) != 1 || node < 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", ent->d_name);
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL) {
+            continue;
+        }
+        if (fgets(buf, sizeof(buf), fp) != NULL) {
+            topology_parse_cpulist(buf, node, node_of);
+        }
+        fclose(fp);
+    }
+    closedir(dir);
+}
+
+static void topology_destroy(threadpool_topology_t *topo)
+{
+    free(topo->node_of);
+    free(topo->cpus);
+    topo->node_of = NULL;
+    topo->cpus = NULL;
+}
+
+/**
+ * 建立候选CPU拓扑：候选为 cpu_list（去重），未指定时为进程当前允许的CPU
+ */
+static int topology_init(threadpool_topology_t *topo, const threadpool_config_t *config)
+{
+    cpu_set_t set;
+    int n = 0;
+
+    memset(topo, 0, sizeof(*topo));
+    CPU_ZERO(&set);
+    if (config->cpu_list != NULL && config->cpu_count > 0) {
+        for (int i = 0; i < config->cpu_count; i++) {
+            CPU_SET(config->cpu_list[i], &set);
+        }
+    } else if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return -1;
+    }
+    int count = CPU_COUNT(&set);
+    if (count <= 0) {
+        return -1;
+    }
+
+    topo->node_of = (int *)calloc(CPU_SETSIZE, sizeof(int));
+    // cpus / node_id / node_first / node_len 共用一块内存
+    topo->cpus = (int *)malloc(sizeof(int) * (size_t)count * 4);
+    if (topo->node_of == NULL || topo->cpus == NULL) {
+        topology_destroy(topo);
+        return -1;
+    }
+    topo->node_id = topo->cpus + count;
+    topo->node_first = topo->node_id + count;
+    topo->node_len = topo->node_first + count;
+    topology_read_nodes(topo->node_of);
+
+    // 插入排序：CPU数量有限，且输入已按编号有序
+    for (int c = 0; c < CPU_SETSIZE && n < count; c++) {
+        if (!CPU_ISSET(c, &set)) {
+            continue;
+        }
+        int j = n++;
+        while (j > 0 && topo->node_of[topo->cpus[j - 1]] > topo->node_of[c]) {
+            topo->cpus[j] = topo->cpus[j - 1];
+            j--;
+        }
+        topo->cpus[j] = c;
+    }
+    topo->cpu_count = n;
+
+    for (int i = 0; i < n; i++) {
+        int node = topo->node_of[topo->cpus[i]];
+        if (topo->node_count == 0 || topo->node_id[topo->node_count - 1] != node) {
+            topo->node_id[topo->node_count] = node;
+            topo->node_first[topo->node_count] = i;
+            topo->node_len[topo->node_count] = 0;
+            topo->node_count++;
+        }
+        topo->node_len[topo->node_count - 1]++;
+    }
+    return 0;
+}
+
+/**
+ * 计算第 i 个工作线程的CPU集合，不需要绑定时返回 false
+ */
+static bool threadpool_worker_cpus(const threadpool_topology_t *topo, const threadpool_config_t *config,
+                                   int partition_count, int i, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    switch (config->affinity) {
+        case THREADPOOL_AFFINITY_EXPLICIT:
+            CPU_SET(config->cpu_list[i % config->cpu_count], set);
+            return true;
+        case THREADPOOL_AFFINITY_COMPACT:
+            CPU_SET(topo->cpus[i % topo->cpu_count], set);
+            return true;
+        case THREADPOOL_AFFINITY_SCATTER: {
+            int g = i % topo->node_count;
+            int k = (i / topo->node_count) % topo->node_len[g];
+            CPU_SET(topo->cpus[topo->node_first[g] + k], set);
+            return true;
+        }
+        case THREADPOOL_AFFINITY_NUMA: {
+            int g = i % partition_count;
+            for (int k = 0; k < topo->node_len[g]; k++) {
+                CPU_SET(topo->cpus[topo->node_first[g] + k], set);
+            }
+            return true;
+        }
+        default:
+            if (config->cpu_list == NULL || config->cpu_count == 0) {
+                return false;
+            }
+            for (int k = 0; k < topo->cpu_count; k++) {
+                CPU_SET(topo->cpus[k], set);
+            }
+            return true;
+    }
+}
+
+/**
+ * 将当前线程的内存分配策略设为优先 node，返回原策略以便恢复（失败时忽略，只影响性能）
+ */
+static bool threadpool_prefer_node(int node, int *old_mode, unsigned long *old_mask)
+{
+    unsigned long mask;
+
+    if (node < 0 || node >= (int)(sizeof(mask) * CHAR_BIT)) {
+        return false;
+    }
+    *old_mask = 0;
+    if (syscall(SYS_get_mempolicy, old_mode, old_mask, sizeof(*old_mask) * CHAR_BIT + 1, NULL, 0) != 0) {
+        return false;
+    }
+    mask = 1UL << node;
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * CHAR_BIT + 1) == 0;
+}
+
+static void threadpool_restore_mempolicy(int mode, unsigned long mask)
+{
+    syscall(SYS_set_mempolicy, mode, mode == MPOL_DEFAULT ? NULL : &mask, sizeof(mask) * CHAR_BIT + 1);
+}
+
+/**
+ * 创建分区的各优先级任务队列与内部对象内存池
+ *
+ * 容量：有上限时即为上限，否则为初始容量。无锁实现在无限制模式下另建可扩容的
+ * 溢出队列；加锁实现只使用后者。NUMA 分区的内存池绑定到本节点。
+ */
+static int threadpool_partition_init(threadpool_partition_t *part, const threadpool_config_t *config)
+{
+    int queue_size = config->queue_size;
+    size_t initial_capacity = (queue_size > 0) ? (size_t)queue_size :
+                              (config->queue_capacity > 0 ? config->queue_capacity : THREADPOOL_DEFAULT_QUEUE_CAPACITY);
+    bool locked = (config->queue_impl == THREADPOOL_QUEUE_LOCKED);
+    for (int i = 0; i < THREADPOOL_PRIORITY_LEVELS; i++) {
+        if (!locked) {
+            part->queue[i] = ring_queue_mpmc_create(initial_capacity, sizeof(threadpool_task_t));
+            if (!part->queue[i]) {
+                return -1;
+            }
+        }
+        if (locked || queue_size == 0) {
+            part->overflow[i] = ring_queue_create(initial_capacity, NULL);
+            if (!part->overflow[i]) {
+                return -1;
+            }
+        }
+    }
+
+    // 内部对象内存池：future/任务组状态，以及溢出节点。
+    // 固定大小类别按从小到大的顺序注册（alloc_fixed 取第一个能容纳的类别）
+    size_t future_size = sizeof(threadpool_future_t);
+    size_t node_size = sizeof(threadpool_task_node_t);
+    size_t future_prealloc = (config->future_prealloc > 0) ? config->future_prealloc : 1;
+    size_t node_prealloc = 0;
+    if (part->overflow[0] != NULL) {
+        node_prealloc = (config->overflow_prealloc > 0) ? config->overflow_prealloc : initial_capacity;
+    }
+    size_t task_pool_bytes = config->task_pool_size;
+    if (task_pool_bytes == 0) {
+        // 预留头部/对齐冗余
+        task_pool_bytes = future_prealloc * (future_size + 128) + node_prealloc * (node_size + 128);
+    }
+    pool_config_t cfg = {
+        .pool_size = task_pool_bytes,
+        .thread_safe = true,
+        .alignment = config->task_pool_alignment ? config->task_pool_alignment : THREADPOOL_DEFAULT_TASK_POOL_ALIGNMENT,
+        .enable_size_classes = false,
+        .size_class_sizes = NULL,
+        .num_size_classes = 0,
+        .numa_bind = part->node >= 0,
+        .numa_node = part->node,
+        .thread_cache = true,
+        .percpu_cache = true
+    };
+    part->task_pool = memory_pool_create_with_config(&cfg);
+    if (part->task_pool == NULL ||
+        memory_pool_add_size_class(part->task_pool, future_size, future_prealloc) < 0) {
+        return -1;
+    }
+    if (node_prealloc > 0) {
+        // 预热溢出节点；失败时稍后按需分配或回退到malloc/free
+        memory_pool_add_size_class(part->task_pool, node_size, node_prealloc);
+    }
+    return 0;
+}
+
+/**
+ * 销毁各分区的任务队列与互斥锁（task_pool 由 threadpool_release 释放）
+ */
+static int threadpool_free_partitions(threadpool_t *pool)
+{
+    int err = 0;
+
+    for (int p = 0; pool->partitions && p < pool->partition_count; p++) {
+        threadpool_partition_t *part = &pool->partitions[p];
+        for (int i = 0; i < THREADPOOL_PRIORITY_LEVELS; i++) {
+            if (part->queue[i]) {
+                ring_queue_mpmc_destroy(part->queue[i]);
+                part->queue[i] = NULL;
+            }
+            if (part->overflow[i]) {
+                ring_queue_destroy(part->overflow[i]);
+                part->overflow[i] = NULL;
+            }
+        }
+        if (pthread_mutex_destroy(&(part->lock)) != 0) {
+            err = -1;
+        }
+    }
+    free(pool->cpu_partition);
+    pool->cpu_partition = NULL;
+    return err;
+}
+
+/**
+ * 创建跟踪缓冲区（capacity 为 2 的幂）
+ */
+static trace_buffer_t *trace_buffer_create(size_t capacity, bool shared)
+{
+    trace_buffer_t *b;
+    size_t size = sizeof(trace_buffer_t) + capacity * sizeof(trace_event_t);
+
+    if (posix_memalign((void **)&b, 64, size) != 0) {
+        return NULL;
+    }
+    memset(b, 0, size);
+    b->shared = shared;
+    return b;
+}
+
+/**
+ * 释放外部提交方跟踪缓冲区
+ */
+static void threadpool_free_ext_trace(threadpool_t *pool)
+{
+    if (pool->ext_trace == NULL) {
+        return;
+    }
+    for (int i = 0; i < THREADPOOL_STAT_SHARDS; i++) {
+        free(pool->ext_trace[i]);
+    }
+    free(pool->ext_trace);
+    pool->ext_trace = NULL;
+}
+
+/**
+ * 在空闲槽位上新建一个工作线程（调用方持有 pool->lock）
+ *
+ * 优先复用编号最小的空闲槽位（先 join 已退出的线程），槽位的本地队列在首次
+ * 使用时创建并一直保留，窃取方遍历的范围 thread_count 因此只增不减。
+ */
+static int threadpool_spawn(threadpool_t *pool)
+{
+    int n = atomic_load(&pool->thread_count);
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (atomic_load(&pool->workers[i].state) != WORKER_RUNNING) {
+            break;
+        }
+    }
+    if (i == pool->capacity) {
+        return -1;
+    }
+
+    threadpool_worker_t *w = &pool->workers[i];
+    if (atomic_load(&w->state) == WORKER_EXITED) {
+        pthread_join(pool->threads[i], NULL);
+        atomic_store(&w->state, WORKER_EMPTY);
+    }
+    if (w->deque == NULL || w->inbox == NULL) {
+        // NUMA 分区的本地队列与收件箱优先从本节点分配；各自判断，部分失败时重试只补建缺少的一个
+        int old_mode = MPOL_DEFAULT;
+        unsigned long old_mask = 0;
+        bool preferred = pool->partition_count > 1 && threadpool_prefer_node(w->part->node, &old_mode, &old_mask);
+        if (w->deque == NULL) {
+            w->deque = ws_deque_create(THREADPOOL_LOCAL_DEQUE_SIZE, sizeof(threadpool_task_t));
+        }
+        if (w->inbox == NULL) {
+            w->inbox = ring_queue_spsc_create(THREADPOOL_INBOX_SIZE);
+        }
+        if (preferred) {
+            threadpool_restore_mempolicy(old_mode, old_mask);
+        }
+        // 缺少任何一个都不启动线程：收件箱只在下面启动线程前打开，不会投递到空收件箱
+        if (w->deque == NULL || w->inbox == NULL) {
+            return -1;
+        }
+    }
+    if (pool->latency_stats && w->latency == NULL) {
+        if (posix_memalign((void **)&w->latency, 64, sizeof(latency_hist_t) * LATENCY_KINDS) != 0) {
+            w->latency = NULL;
+            return -1;
+        }
+        memset(w->latency, 0, sizeof(latency_hist_t) * LATENCY_KINDS);
+    }
+    if (pool->trace_capacity > 0 && w->trace == NULL) {
+        w->trace = trace_buffer_create(pool->trace_capacity, false);
+        if (w->trace == NULL) {
+            return -1;
+        }
+    }
+    if (i == n) {
+        atomic_store_explicit(&pool->thread_count, n + 1, memory_order_release);
+    }
+    if (w->pinned && pthread_attr_setaffinity_np(&pool->attr, sizeof(w->cpus), &w->cpus) != 0) {
+        return -1;
+    }
+
+    memset(w->starve, 0, sizeof(w->starve));
+    atomic_store(&w->state, WORKER_RUNNING);
+    atomic_fetch_add(&pool->started, 1);
+    worker_inbox_set_open(w, true);
+    if (pthread_create(&(pool->threads[i]), &pool->attr, threadpool_worker, (void *)w) != 0) {
+        // 期间已接受的定向任务没有线程执行，取消
+        threadpool_task_t task;
+        worker_inbox_set_open(w, false);
+        while (threadpool_take_inbox(pool, w, &task)) {
+            task_cancel(pool, &task);
+        }
+        atomic_fetch_sub(&pool->started, 1);
+        atomic_store(&w->state, WORKER_EMPTY);
+        return -1;
+    }
+    TRACE(pool, TRACE_SPAWN, i);
+    if (pool->name_prefix[0] != '\0') {
+        // 线程名最长15字节，超长时截断前缀以保留编号
+        char name[16], suffix[12];
+        int suffix_len = snprintf(suffix, sizeof(suffix), "-%d", i);
+        snprintf(name, sizeof(name), "%.*s%s", (int)sizeof(name) - 1 - suffix_len,
+                 pool->name_prefix, suffix);
+        pthread_setname_np(pool->threads[i], name);
+    }
+    return 0;
+}
+
+/**
+ * 负载高时新建一个工作线程（由提交方在没有空闲线程可唤醒时调用）
+ *
+ * 待执行任务数未达到阈值、或已有线程正在新建/调整线程数时直接返回，不阻塞提交方。
+ */
+static void threadpool_grow(threadpool_t *pool)
+{
+    if (atomic_load(&pool->queue_size) < pool->grow_threshold ||
+        pthread_mutex_trylock(&(pool->lock)) != 0) {
+        return;
+    }
+    if (!atomic_load(&pool->shutdown) && atomic_load(&pool->started) < atomic_load(&pool->max_threads)) {
+        threadpool_spawn(pool);
+    }
+    pthread_mutex_unlock(&(pool->lock));
+}
+
+/**
+ * 等待并回收所有工作线程（关闭标志已设置，不会再新建线程）
+ */
+static int threadpool_join_all(threadpool_t *pool)
+{
+    int err = 0;
+    int n = atomic_load(&pool->thread_count);
+
+    for (int i = 0; i < n; i++) {
+        if (atomic_load(&pool->workers[i].state) == WORKER_EMPTY) {
+            continue;
+        }
+        if (pthread_join(pool->threads[i], NULL) != 0) {
+            err = -1;
+        }
+        atomic_store(&pool->workers[i].state, WORKER_EMPTY);
+    }
+    return err;
+}
+
+/**
+ * 按配置创建线程池
+ */
+threadpool_t *threadpool_create_with_config(const threadpool_config_t *config)
+{
+    int i;
+    threadpool_t *pool = NULL;
+    threadpool_topology_t topo;
+
+    // 参数检查
+    if (config == NULL || config->queue_size < 0 ||
+        config->spin_count < 0 || config->yield_count < 0 ||
+        (config->task_pool_alignment & (config->task_pool_alignment - 1)) != 0 ||
+        (config->cpu_list != NULL && config->cpu_count < 0) ||
+        config->affinity < THREADPOOL_AFFINITY_NONE || config->affinity > THREADPOOL_AFFINITY_NUMA ||
+        (config->affinity == THREADPOOL_AFFINITY_EXPLICIT && (config->cpu_list == NULL || config->cpu_count <= 0))) {
+        return NULL;
+    }
+    for (i = 0; config->cpu_list != NULL && i < config->cpu_count; i++) {
+        if (config->cpu_list[i] < 0 || config->cpu_list[i] >= CPU_SETSIZE) {
+            return NULL;
+        }
+    }
+    int thread_count = config->thread_count;
+    int queue_size = config->queue_size;
+    if (thread_count <= 0) {
+        thread_count = 4; // 默认4个线程
+    }
+    // 线程数上下限：未指定时等于初始线程数；槽位数足够 threadpool_resize 使用
+    int min_threads = (config->min_threads > 0) ? config->min_threads : thread_count;
+    int max_threads = (config->max_threads > 0) ? config->max_threads : thread_count;
+    int capacity = (thread_count > THREADPOOL_MAX_THREADS) ? thread_count : THREADPOOL_MAX_THREADS;
+    if (config->min_threads < 0 || config->max_threads < 0 || config->grow_threshold < 0 ||
+        min_threads > thread_count || thread_count > max_threads || max_threads > capacity) {
+        return NULL;
+    }
+
+    // CPU拓扑；不绑定时不需要
+    bool pinned = config->affinity != THREADPOOL_AFFINITY_NONE ||
+                  (config->cpu_list != NULL && config->cpu_count > 0);
+    memset(&topo, 0, sizeof(topo));
+    if (pinned && topology_init(&topo, config) != 0) {
+        return NULL;
+    }
+
+    // 分配线程池结构体内存
+    if ((pool = (threadpool_t *)malloc(sizeof(threadpool_t))) == NULL) {
+        goto err;
+    }
+
+    // 初始化线程池结构体
+    memset(pool, 0, sizeof(threadpool_t));
+    pool->capacity = capacity;
+    atomic_init(&pool->thread_count, 0);
+    atomic_init(&pool->started, 0);
+    atomic_init(&pool->min_threads, min_threads);
+    atomic_init(&pool->max_threads, max_threads);
+    pool->fixed = (min_threads == max_threads);
+    pool->keepalive_ms = (config->keepalive_ms != 0) ? config->keepalive_ms : THREADPOOL_DEFAULT_KEEPALIVE_MS;
+    pool->grow_threshold = (config->grow_threshold > 0) ? config->grow_threshold : THREADPOOL_DEFAULT_GROW_THRESHOLD;
+    pool->latency_stats = config->latency_stats;
+    if (config->trace_capacity > 0) {
+        // 跟踪缓冲区容量向上取整为 2 的幂，时钟基准用于导出时换算
+        size_t cap = 16;
+        while (cap < config->trace_capacity) {
+            cap <<= 1;
+        }
+        pool->trace_capacity = cap;
+        pool->trace_tsc0 = trace_clock();
+        pool->trace_ns0 = now_ns();
+    }
+    if (config->name_prefix != NULL) {
+        snprintf(pool->name_prefix, sizeof(pool->name_prefix), "%s", config->name_prefix);
+    }
+    pool->max_queue_size = queue_size;
+    atomic_init(&pool->queue_size, 0);
+    atomic_init(&pool->queue_high_water, 0);
+    atomic_init(&pool->cancelled, 0);
+    atomic_init(&pool->idle, 0);
+    atomic_init(&pool->spinning, 0);
+    atomic_init(&pool->wake_seq, 0);
+    atomic_init(&pool->shutdown, false);
+    atomic_init(&pool->shutdown_immediate, false);
+    atomic_init(&pool->refs, 1);
+
+    // 空闲策略：单CPU上自旋等不来其他线程提交任务，只保留让出CPU阶段
+    pool->idle_policy = config->idle_policy;
+    pool->spin_count = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? config->spin_count : 0;
+    pool->yield_count = config->yield_count;
+    if (pool->idle_policy == THREADPOOL_IDLE_PARK) {
+        pool->spin_count = 0;
+        pool->yield_count = 0;
+    } else if (pool->idle_policy == THREADPOOL_IDLE_SPIN && pool->spin_count + pool->yield_count == 0) {
+        pool->yield_count = 1;
+    }
+#ifdef DEBUG
+    pool->dbg_free_pool_fixed = 0;
+    pool->dbg_free_malloc = 0;
+    pool->dbg_destroy_free_pool_fixed = 0;
+#endif
+
+    // 外部提交方统计计数槽（按缓存行对齐）
+    if (posix_memalign((void **)&pool->ext_stats, 64, sizeof(threadpool_counters_t) * THREADPOOL_STAT_SHARDS) != 0) {
+        pool->ext_stats = NULL;
+        goto err;
+    }
+    memset(pool->ext_stats, 0, sizeof(threadpool_counters_t) * THREADPOOL_STAT_SHARDS);
+    for (i = 0; i < THREADPOOL_STAT_SHARDS; i++) {
+        pool->ext_stats[i].shared = true;
+    }
+
+    // 外部提交方跟踪缓冲区
+    if (pool->trace_capacity > 0) {
+        pool->ext_trace = (trace_buffer_t **)calloc(THREADPOOL_STAT_SHARDS, sizeof(trace_buffer_t *));
+        if (pool->ext_trace == NULL) {
+            goto err;
+        }
+        for (i = 0; i < THREADPOOL_STAT_SHARDS; i++) {
+            if ((pool->ext_trace[i] = trace_buffer_create(pool->trace_capacity, true)) == NULL) {
+                goto err;
+            }
+        }
+    }
+
+    // 初始化互斥锁
+    if (pthread_mutex_init(&(pool->lock), NULL) != 0) {
+        goto err;
+    }
+
+    // 分区：NUMA 模式下每个节点一个（不超过线程数），否则只有一个
+    int partition_count = 1;
+    if (config->affinity == THREADPOOL_AFFINITY_NUMA) {
+        partition_count = (topo.node_count < max_threads) ? topo.node_count : max_threads;
+    }
+    pool->partitions = (threadpool_partition_t *)calloc(partition_count, sizeof(threadpool_partition_t));
+    if (pool->partitions == NULL) {
+        goto err;
+    }
+    pool->partition_count = partition_count;
+    if (partition_count > 1) {
+        // 外部线程按所在CPU的节点选择分区，不在候选中的节点归入分区0
+        pool->cpu_partition = (int *)calloc(CPU_SETSIZE, sizeof(int));
+        if (pool->cpu_partition == NULL) {
+            goto err;
+        }
+        pool->cpu_partition_size = CPU_SETSIZE;
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            for (int p = 0; p < partition_count; p++) {
+                if (topo.node_id[p] == topo.node_of[c]) {
+                    pool->cpu_partition[c] = p;
+                    break;
+                }
+            }
+        }
+    }
+
+    // 分配线程数组与工作线程槽位
+    // （槽位内含按缓存行对齐的统计计数器）
+    pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * capacity);
+    if (pool->threads == NULL ||
+        posix_memalign((void **)&pool->workers, 64, sizeof(threadpool_worker_t) * capacity) != 0) {
+        pool->workers = NULL;
+        goto err;
+    }
+    memset(pool->workers, 0, sizeof(threadpool_worker_t) * capacity);
+
+    // 逐个分区创建队列与内存池；NUMA 分区在创建期间优先从本节点分配内存
+    for (int p = 0; p < partition_count; p++) {
+        threadpool_partition_t *part = &pool->partitions[p];
+        int old_mode = MPOL_DEFAULT;
+        unsigned long old_mask = 0;
+        bool preferred = false;
+
+        part->index = p;
+        part->node = (config->affinity == THREADPOOL_AFFINITY_NUMA) ? topo.node_id[p] : -1;
+        for (i = 0; i < THREADPOOL_PRIORITY_LEVELS; i++) {
+            atomic_init(&part->overflow_size[i], 0);
+        }
+        if (pthread_mutex_init(&(part->lock), NULL) != 0) {
+            goto err;
+        }
+        if (partition_count > 1) {
+            preferred = threadpool_prefer_node(part->node, &old_mode, &old_mask);
+        }
+        int rc = threadpool_partition_init(part, config);
+        if (preferred) {
+            threadpool_restore_mempolicy(old_mode, old_mask);
+        }
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    // 槽位的分区与CPU绑定在创建时确定，线程数调整时沿用
+    for (i = 0; i < capacity; i++) {
+        threadpool_worker_t *w = &pool->workers[i];
+        w->pool = pool;
+        w->part = &pool->partitions[i % partition_count];
+        w->index = i;
+        w->rng = 2654435761u * (unsigned int)(i + 1);
+        atomic_init(&w->state, WORKER_EMPTY);
+        w->pinned = pinned && threadpool_worker_cpus(&topo, config, partition_count, i, &w->cpus);
+    }
+    topology_destroy(&topo);
+
+    // 创建初始工作线程
+    if (threadpool_init_attr(&pool->attr, config) != 0) {
+        goto err;
+    }
+    pthread_mutex_lock(&(pool->lock));
+    for (i = 0; i < thread_count; i++) {
+        if (threadpool_spawn(pool) != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(pool->lock));
+
+    if (atomic_load(&pool->started) == 0) {
+        // 一个线程也没启动成功
+        pthread_attr_destroy(&pool->attr);
+        goto err;
+    }
+    if (pool->fixed && i < thread_count) {
+        // 固定线程数的线程池只创建成功部分线程时，以实际数量为准
+        atomic_store(&pool->min_threads, i);
+        atomic_store(&pool->max_threads, i);
+    }
+    return pool;
+
+err:
+    topology_destroy(&topo);
+    if (pool) {
+        free(pool->threads);
+        if (pool->workers) {
+            for (i = 0; i < pool->capacity; i++) {
+                if (pool->workers[i].deque) {
+                    ws_deque_destroy(pool->workers[i].deque);
+                }
+                if (pool->workers[i].inbox) {
+                    ring_queue_spsc_destroy(pool->workers[i].inbox);
+                }
+                free(pool->workers[i].latency);
+                free(pool->workers[i].trace);
+            }
+            free(pool->workers);
+        }
+        threadpool_free_partitions(pool);
+        free(pool->ext_stats);
+        threadpool_free_ext_trace(pool);
+        // 销毁同步原语，释放各分区内存池与结构体
+        pthread_mutex_destroy(&(pool->lock));
+        threadpool_release(pool);
+    }
+    return NULL;
+}
+
+/**
+ * 提交单个已填好的任务
+ *
+ * 在工作线程内部提交的普通级别任务直接压入该线程的本地队列；外部线程
+ * 提交、其他级别（或本地队列已满）时进入对应级别的无锁全局队列，均不经过
+ * 全局锁，也不分配内存。
+ */
+static int threadpool_submit(threadpool_t *pool, threadpool_task_t *task, int level)
+{
+    threadpool_counters_t *stats = threadpool_counters(pool);
+
+    task->enqueue_ns = pool->latency_stats ? now_ns() : 0;
+
+    // 预占一个队列名额，检查队列是否已满
+    int pending = atomic_fetch_add(&pool->queue_size, 1);
+    if (pool->max_queue_size > 0 && pending >= pool->max_queue_size) {
+        atomic_fetch_sub(&pool->queue_size, 1);
+        STAT_ADD(stats, rejected, 1);
+        return THREADPOOL_QUEUE_FULL;
+    }
+
+    // 检查是否已关闭（须在计数之后，见 threadpool_worker）
+    if (atomic_load(&pool->shutdown)) {
+        atomic_fetch_sub(&pool->queue_size, 1);
+        STAT_ADD(stats, rejected, 1);
+        return THREADPOOL_SHUTDOWN;
+    }
+
+    // 工作线程内部提交普通级别任务：压入本地队列；本地队列已满则回退到全局队列
+    threadpool_worker_t *self = tls_worker;
+    if ((self == NULL || self->pool != pool || level != THREADPOOL_PRIORITY_NORMAL ||
+         threadpool_push_local(self, task, 1) != 1) &&
+        threadpool_push_global(pool, level, task, 1) != 1) {
+        atomic_fetch_sub(&pool->queue_size, 1);
+        STAT_ADD(stats, rejected, 1);
+        return THREADPOOL_QUEUE_FULL;
+    }
+
+    STAT_ADD(stats, submitted, 1);
+    TRACE(pool, TRACE_SUBMIT, (1 << 8) | level);
+    threadpool_note_depth(pool, pending + 1);
+    threadpool_wake(pool, 1);
+    return THREADPOOL_SUCCESS;
+}
+
+/**
+ * 向线程池添加任务
+ */
+int threadpool_add(threadpool_t *pool, threadpool_task_func function, void *argument)
+{
+    threadpool_task_t task;
+
+    // 参数检查
+    if (pool == NULL || function == NULL) {
+        return THREADPOOL_INVALID;
+    }
+
+    // 初始化任务（内联缓冲区不使用，无需清零）
+    task.function = function;
+    task.argument = argument;
+    task.cancel = NULL;
+    task.flags = 0;
+
+    return threadpool_submit(pool, &task, THREADPOOL_PRIORITY_NORMAL);
+}
+
+/**
+ * 按优先级向线程池添加任务
+ */
+int threadpool_add_priority(threadpool_t *pool, threadpool_task_func function, void *argument,
+                            threadpool_priority_t priority)
+{
+    threadpool_task_t task;
+
+    // 参数检查
+    if (pool == NULL || function == NULL ||
+        (int)priority < 0 || (int)priority >= THREADPOOL_PRIORITY_LEVELS) {
+        return THREADPOOL_INVALID;
+    }
+
+    task.function = function;
+    task.argument = argument;
+    task.cancel = NULL;
+    task.flags = 0;
+
+    return threadpool_submit(pool, &task, (int)priority);
+}
+
+/**
+ * 向线程池添加携带内联参数的任务
+ */
+int threadpool_add_inline(threadpool_t *pool, threadpool_task_func function,
+                          const void *data, size_t size)
+{
+    threadpool_task_t task;
+
+    // 参数检查
+    if (pool == NULL || function == NULL || size > THREADPOOL_INLINE_SIZE ||
+        (data == NULL && size > 0)) {
+        return THREADPOOL_INVALID;
+    }
+
+    // 初始化任务，参数拷贝进任务本身
+    task.function = function;
+    task.argument = NULL;
+    task.cancel = NULL;
+    task.flags = TASK_FLAG_INLINE;
+    if (size > 0) {
+        memcpy(task.payload, data, size);
+    }
+
+    return threadpool_submit(pool, &task, THREADPOOL_PRIORITY_NORMAL);
+}
+
+/**
+ * 向指定工作线程定向投递任务
+ *
+ * 任务以溢出节点（从该线程所在分区的 task_pool 分配）放入其 SPSC 收件箱，
+ * 不计入 queue_size，也不会被其他线程窃取。只有目标线程正在 futex 休眠时
+ * 才发起唤醒，且只唤醒掩码位相同的线程。
+ */
+int threadpool_add_to(threadpool_t *pool, int worker, threadpool_task_func function, void *argument)
+{
+    threadpool_counters_t *stats;
+    threadpool_worker_t *w;
+    threadpool_task_node_t *node;
+    int err = THREADPOOL_SUCCESS;
+
+    // 参数检查
+    if (pool == NULL || function == NULL || worker < 0 || worker >= pool->capacity) {
+        return THREADPOOL_INVALID;
+    }
+    stats = threadpool_counters(pool);
+    w = &pool->workers[worker];
+
+    node = task_node_alloc(pool, w->part);
+    if (node == NULL) {
+        STAT_ADD(stats, rejected, 1);
+        return THREADPOOL_MEMORY_ERROR;
+    }
+    node->task.function = function;
+    node->task.argument = argument;
+    node->task.cancel = NULL;
+    node->task.flags = 0;
+    node->task.enqueue_ns = pool->latency_stats ? now_ns() : 0;
+
+    // 关闭检查在投递方锁内：线程退出前关闭收件箱并处理剩余任务，此前接受的任务不会滞留
+    worker_inbox_lock(w);
+    if (atomic_load(&pool->shutdown)) {
+        err = THREADPOOL_SHUTDOWN;
+    } else if (!w->inbox_open || w->inbox == NULL) {
+        err = THREADPOOL_INVALID;  // 该槽位当前没有运行中的线程
+    } else if (ring_queue_spsc_enqueue(w->inbox, node) != RING_QUEUE_SUCCESS) {
+        err = THREADPOOL_QUEUE_FULL;
+    }
+    worker_inbox_unlock(w);
+    if (err != THREADPOOL_SUCCESS) {
+        task_node_free(pool, w->part, node);
+        STAT_ADD(stats, rejected, 1);
+        return err;
+    }
+
+    STAT_ADD(stats, submitted, 1);
+    TRACE(pool, TRACE_SUBMIT, (1 << 8) | THREADPOOL_PRIORITY_NORMAL);
+
+    // 先入队再读 parked，与 threadpool_idle 先置 parked 再复查收件箱配对，不会丢失唤醒
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&w->parked)) {
+        TRACE(pool, TRACE_WAKE, 1);
+        atomic_fetch_add(&pool->wake_seq, 1);
+        futex_wake_bits(&pool->wake_seq, INT_MAX, worker_wake_bit(w));
+    }
+    return THREADPOOL_SUCCESS;
+}
+
+/**
+ * 批量向线程池添加任务
+ */
+int threadpool_add_batch(threadpool_t *pool, const threadpool_task_func *functions,
+                         void *const *arguments, int count)
+{
+    threadpool_task_t chunk[THREADPOOL_BATCH_CHUNK];
+    int i, reserved, submitted = 0;
+
+    // 参数检查
+    if (pool == NULL || functions == NULL || count < 0) {
+        return THREADPOOL_INVALID;
+    }
+    for (i = 0; i < count; i++) {
+        if (functions[i] == NULL) {
+            return THREADPOOL_INVALID;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // 一次性预占队列名额；有上限时只预占剩余容量
+    threadpool_counters_t *stats = threadpool_counters(pool);
+    int depth;
+    if (pool->max_queue_size > 0) {
+        int cur = atomic_load(&pool->queue_size);
+        do {
+            int room = pool->max_queue_size - cur;
+            if (room <= 0) {
+                STAT_ADD(stats, rejected, (uint64_t)count);
+                return THREADPOOL_QUEUE_FULL;
+            }
+            reserved = (count < room) ? count : room;
+        } while (!atomic_compare_exchange_weak(&pool->queue_size, &cur, cur + reserved));
+        depth = cur + reserved;
+    } else {
+        reserved = count;
+        depth = atomic_fetch_add(&pool->queue_size, reserved) + reserved;
+    }
+
+    // 检查是否已关闭（须在计数之后，见 threadpool_worker）
+    if (atomic_load(&pool->shutdown)) {
+        atomic_fetch_sub(&pool->queue_size, reserved);
+        STAT_ADD(stats, rejected, (uint64_t)count);
+        return THREADPOOL_SHUTDOWN;
+    }
+
+    threadpool_worker_t *self = tls_worker;
+    if (self != NULL && self->pool != pool) {
+        self = NULL;
+    }
+    uint64_t enqueue_ns = pool->latency_stats ? now_ns() : 0;
+
+    while (submitted < reserved) {
+        int n = reserved - submitted;
+        if (n > THREADPOOL_BATCH_CHUNK) {
+            n = THREADPOOL_BATCH_CHUNK;
+        }
+
+        // 初始化任务
+        for (i = 0; i < n; i++) {
+            chunk[i].function = functions[submitted + i];
+            chunk[i].argument = arguments ? arguments[submitted + i] : NULL;
+            chunk[i].cancel = NULL;
+            chunk[i].flags = 0;
+            chunk[i].enqueue_ns = enqueue_ns;
+        }
+
+        // 入队：工作线程内部优先本地队列，其余一次性进入全局队列
+        int done = 0;
+        if (self != NULL) {
+            done = threadpool_push_local(self, chunk, n);
+        }
+        if (done < n) {
+            done += threadpool_push_global(pool, THREADPOOL_PRIORITY_NORMAL, chunk + done, n - done);
+        }
+        submitted += done;
+
+        if (done < n) {
+            break;
+        }
+    }
+
+    // 归还未使用的名额，并按提交数量唤醒工作线程
+    if (submitted < reserved) {
+        atomic_fetch_sub(&pool->queue_size, reserved - submitted);
+    }
+    STAT_ADD(stats, submitted, (uint64_t)submitted);
+    STAT_ADD(stats, rejected, (uint64_t)(count - submitted));
+    TRACE(pool, TRACE_SUBMIT, ((uint64_t)submitted << 8) | THREADPOOL_PRIORITY_NORMAL);
+    threadpool_note_depth(pool, depth - (reserved - submitted));
+    threadpool_wake(pool, submitted);
+
+    return (submitted > 0) ? submitted : THREADPOOL_QUEUE_FULL;
+}
+
+/**
+ * 释放 future 的一个引用，最后一个引用归还内存
+ */
+static void future_release(threadpool_future_t *future)
+{
+    if (atomic_fetch_sub_explicit(&future->refs, 1, memory_order_acq_rel) == 1) {
+        threadpool_t *pool = future->pool;
+        memory_pool_free_fixed(future->mem, future);
+        threadpool_release(pool);
+    }
+}
+
+/**
+ * 设置完成状态，仅在有等待者时才进入内核唤醒
+ */
+static void future_complete(threadpool_future_t *future, uint32_t state)
+{
+    uint32_t old = atomic_exchange_explicit(&future->state, state, memory_order_acq_rel);
+    if (old & FUTURE_WAITERS) {
+        futex_wake_all(&future->state);
+    }
+}
+
+/**
+ * future 任务入口：执行用户函数并发布结果
+ */
+static void future_run(void *arg)
+{
+    future_call_t call;
+    memcpy(&call, arg, sizeof(call));
+
+    call.future->result = (*(call.function))(call.argument);
+    future_complete(call.future, FUTURE_READY);
+    future_release(call.future);
+}
+
+/**
+ * future 任务被丢弃：标记为已取消并唤醒等待者
+ */
+static void future_cancel(void *arg)
+{
+    future_call_t call;
+    memcpy(&call, arg, sizeof(call));
+
+    future_complete(call.future, FUTURE_CANCELLED);
+    future_release(call.future);
+}
+
+/**
+ * 根据完成状态返回结果
+ */
+static inline int future_result(threadpool_future_t *future, uint32_t state, void **result)
+{
+    if (state & FUTURE_READY) {
+        if (result) {
+            *result = future->result;
+        }
+        return THREADPOOL_SUCCESS;
+    }
+    return THREADPOOL_CANCELLED;
+}
+
+/**
+ * 等待 future 完成，deadline 为 NULL 表示不限时
+ */
+static int future_wait_until(threadpool_future_t *future, const struct timespec *deadline, void **result)
+{
+    uint32_t s = atomic_load_explicit(&future->state, memory_order_acquire);
+
+    while ((s & FUTURE_DONE_MASK) == 0) {
+        // 工作线程内部不限时等待时先代为执行任务
+        if (deadline == NULL && threadpool_help(future->pool)) {
+            s = atomic_load_explicit(&future->state, memory_order_acquire);
+            continue;
+        }
+        // 先登记等待者，完成方据此决定是否需要 futex 唤醒
+        if ((s & FUTURE_WAITERS) == 0) {
+            if (!atomic_compare_exchange_weak_explicit(&future->state, &s, s | FUTURE_WAITERS,
+                                                       memory_order_acquire, memory_order_acquire)) {
+                continue;
+            }
+            s |= FUTURE_WAITERS;
+        }
+        if (futex_wait(&future->state, s, deadline) == -1 && errno == ETIMEDOUT) {
+            s = atomic_load_explicit(&future->state, memory_order_acquire);
+            if ((s & FUTURE_DONE_MASK) == 0) {
+                return THREADPOOL_TIMEOUT;
+            }
+            break;
+        }
+        s = atomic_load_explicit(&future->state, memory_order_acquire);
+    }
+
+    return future_result(future, s, result);
+}
+
+/**
+ * 提交带结果句柄的任务
+ */
+threadpool_future_t *threadpool_submit_future(threadpool_t *pool, threadpool_future_func function,
+                                              void *argument)
+{
+    threadpool_task_t task;
+    future_call_t call;
+    threadpool_future_t *future;
+
+    // 参数检查
+    if (pool == NULL || function == NULL) {
+        return NULL;
+    }
+
+    // 完成状态从就近分区内部内存池的固定大小类别分配
+    memory_pool_t *mem = threadpool_local_partition(pool)->task_pool;
+    TRACE(pool, TRACE_ALLOC, 0);
+    future = (threadpool_future_t *)memory_pool_alloc_fixed(mem, sizeof(threadpool_future_t));
+    TRACE(pool, TRACE_ALLOC_END, 0);
+    if (future == NULL) {
+        return NULL;
+    }
+    atomic_init(&future->state, FUTURE_PENDING);
+    atomic_init(&future->refs, 2);
+    future->result = NULL;
+    future->pool = pool;
+    future->mem = mem;
+    atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+
+    // 用户函数与参数随任务内联存放，由 future_run 转调
+    call.function = function;
+    call.argument = argument;
+    call.future = future;
+    task.function = future_run;
+    task.argument = NULL;
+    task.cancel = future_cancel;
+    task.flags = TASK_FLAG_INLINE;
+    memcpy(task.payload, &call, sizeof(call));
+
+    if (threadpool_submit(pool, &task, THREADPOOL_PRIORITY_NORMAL) != THREADPOOL_SUCCESS) {
+        memory_pool_free_fixed(mem, future);
+        atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_relaxed);
+        return NULL;
+    }
+    return future;
+}
+
+/**
+ * 阻塞等待任务完成并获取结果
+ */
+int threadpool_future_wait(threadpool_future_t *future, void **result)
+{
+    if (future == NULL) {
+        return THREADPOOL_INVALID;
+    }
+    return future_wait_until(future, NULL, result);
+}
+
+/**
+ * 非阻塞获取任务结果
+ */
+int threadpool_future_try_get(threadpool_future_t *future, void **result)
+{
+    if (future == NULL) {
+        return THREADPOOL_INVALID;
+    }
+    uint32_t s = atomic_load_explicit(&future->state, memory_order_acquire);
+    if ((s & FUTURE_DONE_MASK) == 0) {
+        return THREADPOOL_TIMEOUT;
+    }
+    return future_result(future, s, result);
+}
+
+/**
+ * 限时等待任务完成并获取结果
+ */
+int threadpool_future_wait_for(threadpool_future_t *future, long timeout_ms, void **result)
+{
+    struct timespec deadline;
+
+    if (future == NULL) {
+        return THREADPOOL_INVALID;
+    }
+    if (timeout_ms <= 0) {
+        return threadpool_future_try_get(future, result);
+    }
+
+    // 换算为 CLOCK_MONOTONIC 绝对截止时间，虚假唤醒后无需重新计算剩余时间
+    deadline_after_ms(&deadline, timeout_ms);
+    return future_wait_until(future, &deadline, result);
+}
+
+/**
+ * 释放任务句柄
+ */
+void threadpool_future_destroy(threadpool_future_t *future)
+{
+    if (future == NULL) {
+        return;
+    }
+    future_release(future);
+}
+
+/**
+ * 任务组完成一个任务：计数归零时清除等待位并唤醒等待者
+ *
+ * 减计数与清除等待位在同一次 CAS 中完成，等待者看到计数归零后可立即
+ * 释放任务组，此后本函数只会对该地址发起 futex 唤醒而不再读写其内容。
+ */
+static void group_task_done(threadpool_group_t *group)
+{
+    uint32_t old = atomic_load_explicit(&group->pending, memory_order_relaxed);
+    uint32_t new_val;
+
+    do {
+        new_val = old - 1;
+        if ((new_val & GROUP_COUNT_MASK) == 0) {
+            new_val = 0;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&group->pending, &old, new_val,
+                                                    memory_order_acq_rel, memory_order_relaxed));
+
+    if (new_val == 0 && (old & GROUP_WAITERS)) {
+        futex_wake_all(&group->pending);
+    }
+}
+
+/**
+ * 任务组任务入口
+ */
+static void group_run(void *arg)
+{
+    group_call_t call;
+    memcpy(&call, arg, sizeof(call));
+
+    (*(call.function))(call.argument);
+    group_task_done(call.group);
+}
+
+/**
+ * 任务组任务被丢弃
+ */
+static void group_cancel(void *arg)
+{
+    group_call_t call;
+    memcpy(&call, arg, sizeof(call));
+
+    atomic_fetch_add_explicit(&call.group->cancelled, 1, memory_order_relaxed);
+    group_task_done(call.group);
+}
+
+/**
+ * 创建任务组
+ */
+threadpool_group_t *threadpool_group_create(threadpool_t *pool)
+{
+    threadpool_group_t *group;
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    // 与 future 共用就近分区内部内存池的固定大小类别
+    memory_pool_t *mem = threadpool_local_partition(pool)->task_pool;
+    TRACE(pool, TRACE_ALLOC, 0);
+    group = (threadpool_group_t *)memory_pool_alloc_fixed(mem, sizeof(threadpool_group_t));
+    TRACE(pool, TRACE_ALLOC_END, 0);
+    if (group == NULL) {
+        return NULL;
+    }
+    atomic_init(&group->pending, 0);
+    atomic_init(&group->cancelled, 0);
+    group->pool = pool;
+    group->mem = mem;
+    atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    return group;
+}
+
+/**
+ * 向任务组添加任务
+ */
+int threadpool_group_add(threadpool_group_t *group, threadpool_task_func function, void *argument)
+{
+    threadpool_task_t task;
+    group_call_t call;
+
+    // 参数检查
+    if (group == NULL || function == NULL) {
+        return THREADPOOL_INVALID;
+    }
+
+    // 先计数再提交，保证等待方不会在任务完成前看到计数归零
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+
+    call.function = function;
+    call.argument = argument;
+    call.group = group;
+    task.function = group_run;
+    task.argument = NULL;
+    task.cancel = group_cancel;
+    task.flags = TASK_FLAG_INLINE;
+    memcpy(task.payload, &call, sizeof(call));
+
+    int err = threadpool_submit(group->pool, &task, THREADPOOL_PRIORITY_NORMAL);
+    if (err != THREADPOOL_SUCCESS) {
+        group_task_done(group);
+    }
+    return err;
+}
+
+/**
+ * 等待任务组中已添加的任务全部完成
+ */
+int threadpool_group_wait(threadpool_group_t *group)
+{
+    if (group == NULL) {
+        return THREADPOOL_INVALID;
+    }
+
+    uint32_t v = atomic_load_explicit(&group->pending, memory_order_acquire);
+    while ((v & GROUP_COUNT_MASK) != 0) {
+        // 工作线程内部等待时先代为执行任务
+        if (threadpool_help(group->pool)) {
+            v = atomic_load_explicit(&group->pending, memory_order_acquire);
+            continue;
+        }
+        // 登记等待者后休眠
+        if ((v & GROUP_WAITERS) == 0) {
+            if (!atomic_compare_exchange_weak_explicit(&group->pending, &v, v | GROUP_WAITERS,
+                                                       memory_order_acquire, memory_order_acquire)) {
+                continue;
+            }
+            v |= GROUP_WAITERS;
+        }
+        futex_wait(&group->pending, v, NULL);
+        v = atomic_load_explicit(&group->pending, memory_order_acquire);
+    }
+
+    return atomic_exchange_explicit(&group->cancelled, 0, memory_order_relaxed) > 0 ?
+           THREADPOOL_CANCELLED : THREADPOOL_SUCCESS;
+}
+
+/**
+ * 销毁任务组
+ */
+void threadpool_group_destroy(threadpool_group_t *group)
+{
+    if (group == NULL) {
+        return;
+    }
+
+    threadpool_group_wait(group);
+
+    threadpool_t *pool = group->pool;
+    memory_pool_free_fixed(group->mem, group);
+    threadpool_release(pool);
+}
+
+static void range_execute(const range_call_t *call);
+
+/**
+ * 子区间任务入口
+ */
+static void range_run(void *arg)
+{
+    range_call_t call;
+    memcpy(&call, arg, sizeof(call));
+
+    range_execute(&call);
+    group_task_done(call.group);
+}
+
+/**
+ * 子区间任务被丢弃
+ */
+static void range_cancel(void *arg)
+{
+    range_call_t call;
+    memcpy(&call, arg, sizeof(call));
+
+    atomic_fetch_add_explicit(&call.group->cancelled, 1, memory_order_relaxed);
+    group_task_done(call.group);
+}
+
+/**
+ * 把子区间 [begin, end) 作为任务提交到同一任务组
+ */
+static int range_spawn(const range_call_t *parent, size_t begin, size_t end)
+{
+    threadpool_task_t task;
+    range_call_t call = *parent;
+    threadpool_group_t *group = parent->group;
+
+    call.begin = begin;
+    call.end = end;
+    task.function = range_run;
+    task.argument = NULL;
+    task.cancel = range_cancel;
+    task.flags = TASK_FLAG_INLINE;
+    memcpy(task.payload, &call, sizeof(call));
+
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    int err = threadpool_submit(group->pool, &task, THREADPOOL_PRIORITY_NORMAL);
+    if (err != THREADPOOL_SUCCESS) {
+        group_task_done(group);
+    }
+    return err;
+}
+
+/**
+ * 是否值得再分出一半：有线程空闲（休眠或仍在自旋/让出CPU等待），或本地队列
+ * 已被窃取一空；调用方不是工作线程时至少分出一次，把区间交给线程池
+ */
+static inline bool range_should_split(threadpool_t *pool, threadpool_worker_t *self, bool offered)
+{
+    if (atomic_load_explicit(&pool->idle, memory_order_relaxed) +
+        atomic_load_explicit(&pool->spinning, memory_order_relaxed) > 0) {
+        return true;
+    }
+    if (self == NULL) {
+        return !offered;
+    }
+    return ws_deque_is_empty(self->deque);
+}
+
+/**
+ * 惰性二分执行区间：每处理 grain 个元素检查一次是否需要拆分
+ */
+static void range_execute(const range_call_t *call)
+{
+    threadpool_t *pool = call->group->pool;
+    threadpool_worker_t *self = tls_worker;
+    size_t begin = call->begin;
+    size_t end = call->end;
+    size_t grain = call->grain;
+    bool offered = false;
 
-    // 任务节点内存池
-    memory_pool_t *task_pool;
+    if (self != NULL && self->pool != pool) {
+        self = NULL;
+    }
 
-#ifdef DEBUG
-    // 调试统计
-    size_t dbg_alloc_fixed;
-    size_t dbg_alloc_pool;
-    size_t dbg_alloc_malloc;
-    size_t dbg_free_pool_fixed;
-    size_t dbg_free_malloc;
-    size_t dbg_destroy_free_pool_fixed;
-    size_t dbg_destroy_free_malloc;
-#endif
-};
+    while (begin < end) {
+        if (end - begin > grain && range_should_split(pool, self, offered)) {
+            size_t mid = begin + (end - begin) / 2;
+            // 提交失败（队列已满或正在关闭）时由自己执行剩余部分
+            if (range_spawn(call, mid, end) == THREADPOOL_SUCCESS) {
+                offered = true;
+                end = mid;
+                continue;
+            }
+        }
+        size_t stop = (end - begin > grain) ? begin + grain : end;
+        (*(call->function))(begin, stop, call->ctx);
+        begin = stop;
+    }
+}
 
 /**
- * 工作线程函数
+ * 并行执行区间 [begin, end)
  */
-static void *threadpool_worker(void *arg) 
+int threadpool_parallel_for(threadpool_t *pool, size_t begin, size_t end, size_t grain,
+                            threadpool_range_func function, void *ctx)
 {
-    threadpool_t *pool = (threadpool_t *)arg;
-    threadpool_task_t *task = NULL;
+    threadpool_group_t group;
+    range_call_t call;
 
-    while (1) {
-        // 获取互斥锁
-        pthread_mutex_lock(&(pool->lock));
+    // 参数检查
+    if (pool == NULL || function == NULL) {
+        return THREADPOOL_INVALID;
+    }
+    if (begin >= end) {
+        return THREADPOOL_SUCCESS;
+    }
 
-        // 等待任务或关闭信号
-        while ((pool->queue_size == 0) && (!pool->shutdown)) {
-            pthread_cond_wait(&(pool->notify), &(pool->lock));
+    if (grain == 0) {
+        size_t chunks = (size_t)atomic_load(&pool->started) * THREADPOOL_RANGE_CHUNKS_PER_THREAD;
+        grain = (end - begin) / chunks;
+        if (grain == 0) {
+            grain = 1;
         }
+    }
 
-        // 如果立即关闭，或优雅关闭并且队列为空，则退出
-        if (pool->shutdown && (pool->shutdown_immediate || pool->queue_size == 0)) {
-            pthread_mutex_unlock(&(pool->lock));
-            pthread_exit(NULL);
-        }
+    // 调用期间阻塞，任务组直接放在栈上
+    atomic_init(&group.pending, 0);
+    atomic_init(&group.cancelled, 0);
+    group.pool = pool;
+    group.mem = NULL;
 
-        // 取出一个任务（peek+dequeue）
-        if (pool->queue_size > 0) {
-            void *elem = NULL;
-            if (ring_queue_peek(pool->queue, &elem) == RING_QUEUE_SUCCESS && elem != NULL) {
-                task = (threadpool_task_t *)elem;
-                // 先从队列移除，避免被其他线程重复获取
-                if (ring_queue_dequeue(pool->queue) == RING_QUEUE_SUCCESS) {
-                    pool->queue_size--;
-                    pool->active++; // 标记活跃任务
-                } else {
-                    // 理论上不应发生，保守处理
-                    task = NULL;
-                }
-            }
+    call.function = function;
+    call.ctx = ctx;
+    call.begin = begin;
+    call.end = end;
+    call.grain = grain;
+    call.group = &group;
 
-            // 解锁，允许其他线程访问队列
-            pthread_mutex_unlock(&(pool->lock));
-
-            // 执行任务
-            if (task) {
-                (*(task->function))(task->argument);
-                // 任务完成后释放内存
-                if (pool->task_pool) {
-                    switch (task->alloc_type) {
-                        case 1: // fixed size class
-                            memory_pool_free_fixed(pool->task_pool, task);
-#ifdef DEBUG
-                            pool->dbg_free_pool_fixed++;
-#endif
-                            break;
-                        case 2: // general pool
-                            memory_pool_free(pool->task_pool, task);
-#ifdef DEBUG
-                            pool->dbg_free_pool_fixed++; // 统计为来自内存池的释放
-#endif
-                            break;
-                        default: // 3 or others -> malloc
-                            free(task);
-#ifdef DEBUG
-                            pool->dbg_free_malloc++;
-#endif
-                            break;
-                    }
-                } else {
-                    free(task);
-#ifdef DEBUG
-                    pool->dbg_free_malloc++;
-#endif
-                }
-            }
+    // 调用线程执行其中一部分，再等待（工作线程内部则协助执行）分出去的部分
+    range_execute(&call);
+    return threadpool_group_wait(&group);
+}
 
-            // 任务完成，更新活跃计数
-            pthread_mutex_lock(&(pool->lock));
-            pool->active--;
-            // 如果优雅关闭并且队列空且无活跃任务，唤醒等待者
-            if (pool->shutdown && !pool->shutdown_immediate && pool->queue_size == 0 && pool->active == 0) {
-                pthread_cond_broadcast(&(pool->empty));
-            }
-            pthread_mutex_unlock(&(pool->lock));
-        } else {
-            pthread_mutex_unlock(&(pool->lock));
-        }
+static void warmup_range(size_t begin, size_t end, void *ctx)
+{
+    for (size_t i = begin; i < end; i++) {
+        memory_pool_warmup_chunk((memory_pool_t *)ctx, i);
     }
+}
 
-    return NULL;
+/**
+ * 在线程池上并行预热内存池
+ */
+int threadpool_warmup_memory_pool(threadpool_t *pool, struct memory_pool *mem)
+{
+    if (pool == NULL || mem == NULL) {
+        return THREADPOOL_INVALID;
+    }
+    // 每块 64MB 起，缺页耗时远大于调度开销，按块逐个拆分
+    return threadpool_parallel_for(pool, 0, memory_pool_warmup_chunks(mem), 1, warmup_range, mem);
 }
 
 /**
- * 创建线程池
+ * 读取一组计数器中仍在进行的活动/等待时间
  */
-threadpool_t *threadpool_create(int thread_count, int queue_size) 
+static void counters_times(const threadpool_counters_t *c, uint64_t now, uint64_t *busy, uint64_t *idle)
 {
-    int i;
-    threadpool_t *pool;
+    uint64_t active_since = atomic_load_explicit(&c->active_since, memory_order_relaxed);
+    uint64_t idle_since = atomic_load_explicit(&c->idle_since, memory_order_relaxed);
 
-    // 参数检查
-    if (thread_count <= 0) {
-        thread_count = 4; // 默认4个线程
+    *busy = atomic_load_explicit(&c->busy_ns, memory_order_relaxed);
+    *idle = atomic_load_explicit(&c->idle_ns, memory_order_relaxed);
+    if (active_since != 0 && now > active_since) {
+        *busy += now - active_since;
     }
-
-    // 分配线程池结构体内存
-    if ((pool = (threadpool_t *)malloc(sizeof(threadpool_t))) == NULL) {
-        goto err;
+    if (idle_since != 0 && now > idle_since) {
+        *idle += now - idle_since;
     }
+}
 
-    // 初始化线程池结构体
-    memset(pool, 0, sizeof(threadpool_t));
-    pool->thread_count = thread_count;
-    pool->max_queue_size = queue_size;
-    pool->queue = NULL;
-    pool->queue_size = 0;
-    pool->shutdown = false;
-    pool->shutdown_immediate = false;
-    pool->active = 0;
-    pool->started = 0;
-    pool->task_pool = NULL;
-#ifdef DEBUG
-    pool->dbg_alloc_fixed = 0;
-    pool->dbg_alloc_pool = 0;
-    pool->dbg_alloc_malloc = 0;
-    pool->dbg_free_pool_fixed = 0;
-    pool->dbg_free_malloc = 0;
-    pool->dbg_destroy_free_pool_fixed = 0;
-    pool->dbg_destroy_free_malloc = 0;
-#endif
-
-    // 分配线程数组内存
-    pool->threads = (pthread_t *)malloc(sizeof(pthread_t) * thread_count);
-    if (pool->threads == NULL) {
-        goto err;
+/**
+ * 获取线程池运行统计
+ */
+int threadpool_get_stats(threadpool_t *pool, threadpool_stats_t *stats)
+{
+    if (pool == NULL || stats == NULL) {
+        return THREADPOOL_INVALID;
     }
 
-    // 初始化互斥锁和条件变量
-    if (pthread_mutex_init(&(pool->lock), NULL) != 0 ||
-        pthread_cond_init(&(pool->notify), NULL) != 0 ||
-        pthread_cond_init(&(pool->empty), NULL) != 0) {
-        goto err;
+    memset(stats, 0, sizeof(*stats));
+    uint64_t now = now_ns();
+    int n = atomic_load_explicit(&pool->thread_count, memory_order_acquire);
+    for (int i = 0; i < n + THREADPOOL_STAT_SHARDS; i++) {
+        const threadpool_counters_t *c = (i < n) ? &pool->workers[i].stats : &pool->ext_stats[i - n];
+        uint64_t busy, idle;
+        stats->submitted += atomic_load_explicit(&c->submitted, memory_order_relaxed);
+        stats->rejected += atomic_load_explicit(&c->rejected, memory_order_relaxed);
+        stats->completed += atomic_load_explicit(&c->completed, memory_order_relaxed);
+        stats->local_pushes += atomic_load_explicit(&c->local_pushes, memory_order_relaxed);
+        stats->steals += atomic_load_explicit(&c->steals, memory_order_relaxed);
+        stats->alloc_fixed += atomic_load_explicit(&c->alloc_fixed, memory_order_relaxed);
+        stats->alloc_pool += atomic_load_explicit(&c->alloc_pool, memory_order_relaxed);
+        stats->alloc_malloc += atomic_load_explicit(&c->alloc_malloc, memory_order_relaxed);
+        counters_times(c, now, &busy, &idle);
+        stats->busy_ns += busy;
+        stats->idle_ns += idle;
     }
+    stats->cancelled = atomic_load_explicit(&pool->cancelled, memory_order_relaxed);
+    stats->queue_depth = atomic_load(&pool->queue_size);
+    stats->queue_high_water = atomic_load(&pool->queue_high_water);
+    stats->threads = atomic_load(&pool->started);
+    return THREADPOOL_SUCCESS;
+}
 
-    // 创建任务队列（容量：若queue_size==0则给一个初始容量）
-    size_t initial_capacity = (queue_size > 0) ? (size_t)queue_size : 1024;
-    pool->queue = ring_queue_create(initial_capacity, NULL);
-    if (!pool->queue) {
-        goto err;
+/**
+ * 获取各工作线程的运行统计
+ */
+int threadpool_get_worker_stats(threadpool_t *pool, threadpool_worker_stats_t *stats, int count)
+{
+    if (pool == NULL || stats == NULL || count < 0) {
+        return THREADPOOL_INVALID;
     }
 
-    // 创建任务内存池（固定大小类别：threadpool_task_t）
-    {
-        size_t class_size = sizeof(threadpool_task_t);
-        size_t task_pool_bytes = initial_capacity * (class_size + 128); // 预留头部/对齐冗余
-        size_t class_sizes_arr[1] = { class_size };
-        pool_config_t cfg = {
-            .pool_size = task_pool_bytes,
-            .thread_safe = true,
-            .alignment = DEFAULT_ALIGNMENT,
-            .enable_size_classes = true,
-            .size_class_sizes = class_sizes_arr,
-            .num_size_classes = 1
-        };
-        pool->task_pool = memory_pool_create_with_config(&cfg);
-        if (pool->task_pool) {
-            // 预热固定大小块
-            memory_pool_add_size_class(pool->task_pool, class_size, initial_capacity);
-        }
-        // 如果创建失败，稍后回退到malloc/free
-    }
-
-    // 创建工作线程
-    for (i = 0; i < thread_count; i++) {
-        if (pthread_create(&(pool->threads[i]), NULL, threadpool_worker, (void *)pool) != 0) {
-            // 记录已创建线程数，随后销毁时只join这些
-            break;
-        }
-        pool->started++;
+    uint64_t now = now_ns();
+    int n = atomic_load_explicit(&pool->thread_count, memory_order_acquire);
+    if (n > count) {
+        n = count;
     }
-
-    if (pool->started == 0) {
-        // 一个线程也没启动成功
-        goto err;
+    for (int i = 0; i < n; i++) {
+        const threadpool_worker_t *w = &pool->workers[i];
+        stats[i].index = i;
+        stats[i].running = atomic_load(&w->state) == WORKER_RUNNING;
+        stats[i].submitted = atomic_load_explicit(&w->stats.submitted, memory_order_relaxed);
+        stats[i].completed = atomic_load_explicit(&w->stats.completed, memory_order_relaxed);
+        stats[i].local_pushes = atomic_load_explicit(&w->stats.local_pushes, memory_order_relaxed);
+        stats[i].steals = atomic_load_explicit(&w->stats.steals, memory_order_relaxed);
+        counters_times(&w->stats, now, &stats[i].busy_ns, &stats[i].idle_ns);
     }
-    return pool;
+    return n;
+}
 
-err:
-    if (pool) {
-        if (pool->threads) {
-            // 如有部分线程已创建，触发立即关闭并等待
-            if (pool->started > 0) {
-                pthread_mutex_lock(&(pool->lock));
-                pool->shutdown = true;
-                pool->shutdown_immediate = true;
-                pthread_cond_broadcast(&(pool->notify));
-                pthread_mutex_unlock(&(pool->lock));
-                for (i = 0; i < pool->started; i++) {
-                    pthread_join(pool->threads[i], NULL);
-                }
-            }
-            free(pool->threads);
+/**
+ * 合并各工作线程的延迟直方图，返回样本数
+ */
+static uint64_t latency_merge(threadpool_t *pool, int kind, uint64_t *buckets,
+                              uint64_t *sum, uint64_t *min, uint64_t *max)
+{
+    uint64_t count = 0;
+    int n = atomic_load_explicit(&pool->thread_count, memory_order_acquire);
+
+    memset(buckets, 0, sizeof(uint64_t) * LATENCY_BUCKETS);
+    *sum = 0;
+    *min = 0;
+    *max = 0;
+    for (int i = 0; i < n; i++) {
+        const latency_hist_t *h = pool->workers[i].latency ? &pool->workers[i].latency[kind] : NULL;
+        if (h == NULL || atomic_load_explicit(&h->count, memory_order_relaxed) == 0) {
+            continue;
         }
-        if (pool->queue) {
-            ring_queue_destroy(pool->queue);
+        uint64_t hmin = atomic_load_explicit(&h->min_ns, memory_order_relaxed);
+        uint64_t hmax = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+        if (count == 0 || hmin < *min) {
+            *min = hmin;
         }
-        if (pool->task_pool) {
-            memory_pool_destroy(pool->task_pool);
+        if (hmax > *max) {
+            *max = hmax;
+        }
+        *sum += atomic_load_explicit(&h->sum_ns, memory_order_relaxed);
+        // 样本数取各桶之和，与分位数计算保持一致
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            uint64_t c = atomic_load_explicit(&h->buckets[b], memory_order_relaxed);
+            buckets[b] += c;
+            count += c;
         }
-        // 销毁同步原语
-        pthread_mutex_destroy(&(pool->lock));
-        pthread_cond_destroy(&(pool->notify));
-        pthread_cond_destroy(&(pool->empty));
-        free(pool);
     }
-    return NULL;
+    return count;
 }
 
 /**
- * 向线程池添加任务
+ * 按合并后的直方图求分位数：返回累计样本数首次达到该分位的桶的上界（不超过最大值）
  */
-int threadpool_add(threadpool_t *pool, threadpool_task_func function, void *argument) 
+static uint64_t latency_value_at(const uint64_t *buckets, uint64_t count, uint64_t max, double percentile)
 {
-    threadpool_task_t *task;
-    unsigned char alloc_type = 0;
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)count + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= target) {
+            uint64_t v = latency_upper(b);
+            return (v < max) ? v : max;
+        }
+    }
+    return max;
+}
 
-    // 参数检查
-    if (pool == NULL || function == NULL) {
+/**
+ * 获取任务延迟分布
+ */
+int threadpool_get_latency(threadpool_t *pool, threadpool_latency_kind_t kind, threadpool_latency_t *latency)
+{
+    uint64_t buckets[LATENCY_BUCKETS];
+    uint64_t sum, min, max;
+
+    if (pool == NULL || latency == NULL || !pool->latency_stats ||
+        kind < THREADPOOL_LATENCY_WAIT || kind > THREADPOOL_LATENCY_RUN) {
         return THREADPOOL_INVALID;
     }
 
-    // 获取锁
-    if (pthread_mutex_lock(&(pool->lock)) != 0) {
-        return THREADPOOL_LOCK_FAILURE;
-    }
+    uint64_t count = latency_merge(pool, kind, buckets, &sum, &min, &max);
+    latency->count = count;
+    latency->min_ns = min;
+    latency->max_ns = max;
+    latency->mean_ns = count ? sum / count : 0;
+    latency->p50_ns = latency_value_at(buckets, count, max, 50.0);
+    latency->p99_ns = latency_value_at(buckets, count, max, 99.0);
+    latency->p999_ns = latency_value_at(buckets, count, max, 99.9);
+    return THREADPOOL_SUCCESS;
+}
 
-    // 检查队列是否已满
-    if (pool->max_queue_size > 0 && pool->queue_size >= pool->max_queue_size) {
-        pthread_mutex_unlock(&(pool->lock));
-        return THREADPOOL_QUEUE_FULL;
-    }
+/**
+ * 获取任务延迟的任意分位数
+ */
+int threadpool_latency_percentile(threadpool_t *pool, threadpool_latency_kind_t kind,
+                                  double percentile, uint64_t *value_ns)
+{
+    uint64_t buckets[LATENCY_BUCKETS];
+    uint64_t sum, min, max;
 
-    // 检查是否已关闭
-    if (pool->shutdown) {
-        pthread_mutex_unlock(&(pool->lock));
-        return THREADPOOL_SHUTDOWN;
+    if (pool == NULL || value_ns == NULL || !pool->latency_stats ||
+        kind < THREADPOOL_LATENCY_WAIT || kind > THREADPOOL_LATENCY_RUN ||
+        !(percentile >= 0.0 && percentile <= 100.0)) {
+        return THREADPOOL_INVALID;
     }
 
-    // 创建任务结构体
-    if (pool->task_pool) {
-        task = (threadpool_task_t *)memory_pool_alloc_fixed(pool->task_pool, sizeof(threadpool_task_t));
-        if (task) {
-            alloc_type = 1;
-#ifdef DEBUG
-            pool->dbg_alloc_fixed++;
-#endif
-        } else {
-            // 内存池不足时回退到通用分配，再不行则malloc
-            task = (threadpool_task_t *)memory_pool_alloc(pool->task_pool, sizeof(threadpool_task_t));
-            if (task) {
-                alloc_type = 2;
-#ifdef DEBUG
-                pool->dbg_alloc_pool++;
-#endif
-            } else {
-                task = (threadpool_task_t *)malloc(sizeof(threadpool_task_t));
-                if (task) {
-                    alloc_type = 3;
-#ifdef DEBUG
-                    pool->dbg_alloc_malloc++;
-#endif
-                }
-            }
+    uint64_t count = latency_merge(pool, kind, buckets, &sum, &min, &max);
+    *value_ns = latency_value_at(buckets, count, max, percentile);
+    return THREADPOOL_SUCCESS;
+}
+
+/**
+ * 导出一个跟踪缓冲区中的事件
+ */
+static void trace_dump_buffer(FILE *fp, threadpool_t *pool, const trace_buffer_t *b,
+                              int tid, double us_per_tick, bool *first)
+{
+    static const char *names[] = {
+        NULL, "submit", "dequeue", "task", "task", "steal", "park", "park",
+        "wake", "lock_wait", "lock_wait", "alloc", "alloc", "spawn", "retire"
+    };
+    uint64_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+    uint64_t i = (head > pool->trace_capacity) ? head - pool->trace_capacity : 0;
+
+    for (; i < head; i++) {
+        const trace_event_t *e = &b->events[i & (pool->trace_capacity - 1)];
+        uint64_t info = atomic_load_explicit(&e->info, memory_order_acquire);
+        uint64_t ts = atomic_load_explicit(&e->ts, memory_order_relaxed);
+        int type = (int)(info >> 56);
+        uint64_t arg = info & TRACE_ARG_MASK;
+        if (type <= 0 || type > TRACE_RETIRE || ts < pool->trace_tsc0) {
+            continue;
         }
-    } else {
-        task = (threadpool_task_t *)malloc(sizeof(threadpool_task_t));
-        if (task) {
-            alloc_type = 3;
-#ifdef DEBUG
-            pool->dbg_alloc_malloc++;
-#endif
+
+        double us = (double)(ts - pool->trace_tsc0) * us_per_tick;
+        fprintf(fp, "%s\n{\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,",
+                *first ? "" : ",", names[type], tid, us);
+        *first = false;
+        switch (type) {
+        case TRACE_START:
+            fprintf(fp, "\"ph\":\"B\",\"args\":{\"fn\":\"0x%llx\"}}", (unsigned long long)arg);
+            break;
+        case TRACE_PARK:
+        case TRACE_LOCK:
+        case TRACE_ALLOC:
+            fprintf(fp, "\"ph\":\"B\"}");
+            break;
+        case TRACE_END:
+        case TRACE_UNPARK:
+        case TRACE_LOCKED:
+        case TRACE_ALLOC_END:
+            fprintf(fp, "\"ph\":\"E\"}");
+            break;
+        case TRACE_SUBMIT:
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"count\":%llu,\"priority\":%llu}}",
+                    (unsigned long long)(arg >> 8), (unsigned long long)(arg & 0xff));
+            break;
+        case TRACE_DEQUEUE:
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"pending\":%lld}}", (long long)(int)arg);
+            break;
+        case TRACE_STEAL:
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"victim\":%llu}}", (unsigned long long)arg);
+            break;
+        case TRACE_WAKE:
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"count\":%llu}}", (unsigned long long)arg);
+            break;
+        case TRACE_SPAWN:
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"slot\":%llu}}", (unsigned long long)arg);
+            break;
+        default:
+            fprintf(fp, "\"ph\":\"i\",\"s\":\"t\"}");
+            break;
         }
     }
-    if (task == NULL) {
-        pthread_mutex_unlock(&(pool->lock));
-        return THREADPOOL_MEMORY_ERROR;
+}
+
+/**
+ * 导出跟踪事件为 Chrome trace JSON
+ */
+int threadpool_trace_dump(threadpool_t *pool, const char *path)
+{
+    if (pool == NULL || path == NULL || pool->trace_capacity == 0) {
+        return THREADPOOL_INVALID;
     }
 
-    // 初始化任务
-    task->function = function;
-    task->argument = argument;
-    task->alloc_type = alloc_type;
-    // 入队，如果容量不足且无限制模式，尝试扩容
-    if (ring_queue_is_full(pool->queue)) {
-        if (pool->max_queue_size == 0) {
-            size_t new_cap = ring_queue_capacity(pool->queue) * 2;
-            if (new_cap == 0) new_cap = 1024;
-            ring_queue_resize(pool->queue, new_cap);
-        }
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        return THREADPOOL_IO_ERROR;
     }
-    if (ring_queue_is_full(pool->queue)) {
-        // 仍然满且有限制，报错并回收task
-        if (pool->task_pool) {
-            switch (task->alloc_type) {
-                case 1:
-                    memory_pool_free_fixed(pool->task_pool, task);
-#ifdef DEBUG
-                    pool->dbg_free_pool_fixed++;
-#endif
-                    break;
-                case 2:
-                    memory_pool_free(pool->task_pool, task);
-#ifdef DEBUG
-                    pool->dbg_free_pool_fixed++;
-#endif
-                    break;
-                default:
-                    free(task);
-#ifdef DEBUG
-                    pool->dbg_free_malloc++;
-#endif
-                    break;
-            }
-        } else {
-            free(task);
-#ifdef DEBUG
-            pool->dbg_free_malloc++;
-#endif
+
+    // 以创建以来的时钟读数与纳秒数之比换算跟踪时钟（非 x86 上为 1 纳秒）
+    uint64_t ticks = trace_clock() - pool->trace_tsc0;
+    uint64_t ns = now_ns() - pool->trace_ns0;
+    double us_per_tick = (ticks > 0) ? (double)ns / (double)ticks / 1000.0 : 0.001;
+    bool first = true;
+
+    fprintf(fp, "{\"traceEvents\":[");
+    int n = atomic_load_explicit(&pool->thread_count, memory_order_acquire);
+    for (int i = 0; i < n; i++) {
+        const trace_buffer_t *b = pool->workers[i].trace;
+        if (b == NULL) {
+            continue;
         }
-        pthread_mutex_unlock(&(pool->lock));
-        return THREADPOOL_QUEUE_FULL;
+        fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"worker-%d\"}}", first ? "" : ",", i + 1, i);
+        first = false;
+        trace_dump_buffer(fp, pool, b, i + 1, us_per_tick, &first);
     }
-    if (ring_queue_enqueue(pool->queue, task) != RING_QUEUE_SUCCESS) {
-        // 极端情况下的失败
-        if (pool->task_pool) {
-            switch (task->alloc_type) {
-                case 1:
-                    memory_pool_free_fixed(pool->task_pool, task);
-#ifdef DEBUG
-                    pool->dbg_free_pool_fixed++;
-#endif
-                    break;
-                case 2:
-                    memory_pool_free(pool->task_pool, task);
-#ifdef DEBUG
-                    pool->dbg_free_pool_fixed++;
-#endif
-                    break;
-                default:
-                    free(task);
-#ifdef DEBUG
-                    pool->dbg_free_malloc++;
-#endif
-                    break;
-            }
-        } else {
-            free(task);
-#ifdef DEBUG
-            pool->dbg_free_malloc++;
-#endif
+    for (int k = 0; k < THREADPOOL_STAT_SHARDS; k++) {
+        const trace_buffer_t *b = pool->ext_trace[k];
+        if (atomic_load_explicit(&b->head, memory_order_acquire) == 0) {
+            continue;
         }
-        pthread_mutex_unlock(&(pool->lock));
-        return THREADPOOL_QUEUE_FULL;
+        fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"name\":\"submitter-%d\"}}", first ? "" : ",", 1000 + k, k);
+        first = false;
+        trace_dump_buffer(fp, pool, b, 1000 + k, us_per_tick, &first);
     }
-    pool->queue_size++;
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ns\"}\n");
 
-    // 通知一个等待的工作线程
-    if (pthread_cond_signal(&(pool->notify)) != 0) {
-        pthread_mutex_unlock(&(pool->lock));
+    int err = ferror(fp) ? THREADPOOL_IO_ERROR : THREADPOOL_SUCCESS;
+    if (fclose(fp) != 0) {
+        err = THREADPOOL_IO_ERROR;
+    }
+    return err;
+}
+
+/**
+ * 调整线程数量
+ */
+int threadpool_resize(threadpool_t *pool, int thread_count)
+{
+    int err = THREADPOOL_SUCCESS;
+
+    if (pool == NULL || thread_count <= 0 || thread_count > pool->capacity) {
+        return THREADPOOL_INVALID;
+    }
+    if (threadpool_mutex_lock(pool, &(pool->lock)) != 0) {
         return THREADPOOL_LOCK_FAILURE;
     }
+    if (atomic_load(&pool->shutdown)) {
+        pthread_mutex_unlock(&(pool->lock));
+        return THREADPOOL_SHUTDOWN;
+    }
 
-    // 释放锁
-    pthread_mutex_unlock(&(pool->lock));
-    return THREADPOOL_SUCCESS;
+    if (pool->fixed || atomic_load(&pool->min_threads) > thread_count) {
+        atomic_store(&pool->min_threads, thread_count);
+    }
+    atomic_store(&pool->max_threads, thread_count);
+
+    // 不足下限的立即新建
+    while (atomic_load(&pool->started) < atomic_load(&pool->min_threads)) {
+        if (threadpool_spawn(pool) != 0) {
+            err = THREADPOOL_THREAD_FAILURE;
+            break;
+        }
+    }
+    // 超出上限的线程在下次取任务前退出，唤醒休眠的线程使其检查
+    if (atomic_load(&pool->started) > thread_count) {
+        threadpool_wake_all(pool);
+    }
+
+    if (pthread_mutex_unlock(&(pool->lock)) != 0) {
+        err = THREADPOOL_LOCK_FAILURE;
+    }
+    return err;
 }
 
 /**
  * 销毁线程池
  */
-int threadpool_destroy(threadpool_t *pool, int flags) 
+int threadpool_destroy(threadpool_t *pool, int flags)
 {
     int i, err = 0;
-    (void)flags;
 
     if (pool == NULL) {
         return THREADPOOL_INVALID;
     }
 
     // 获取锁
-    if (pthread_mutex_lock(&(pool->lock)) != 0) {
+    if (threadpool_mutex_lock(pool, &(pool->lock)) != 0) {
         return THREADPOOL_LOCK_FAILURE;
     }
 
     // 检查是否已经关闭
-    if (pool->shutdown) {
+    if (atomic_load(&pool->shutdown)) {
         pthread_mutex_unlock(&(pool->lock));
         return THREADPOOL_SHUTDOWN;
     }
 
     // 设置关闭标志
-    pool->shutdown = true;
-    pool->shutdown_immediate = (flags & THREADPOOL_IMMEDIATE) ? true : false;
-
-    // 唤醒所有等待的工作线程
-    if (pthread_cond_broadcast(&(pool->notify)) != 0) {
-        err = THREADPOOL_LOCK_FAILURE;
-    }
+    atomic_store(&pool->shutdown_immediate, (flags & THREADPOOL_IMMEDIATE) ? true : false);
+    atomic_store(&pool->shutdown, true);
 
-    // 优雅关闭：等待队列清空且无活跃任务
-    if (!pool->shutdown_immediate) {
-        while ((pool->queue_size > 0 || pool->active > 0) && err == 0) {
-            if (pthread_cond_wait(&(pool->empty), &(pool->lock)) != 0) {
-                err = THREADPOOL_LOCK_FAILURE;
-                break;
-            }
-        }
-    }
+    // 唤醒所有休眠的工作线程
+    threadpool_wake_all(pool);
 
-    // 释放锁，让出给join期间可能需要的同步（理论上不需要，但保持一致）
+    // 释放锁；优雅关闭时工作线程会在所有任务完成后自行退出
     if (pthread_mutex_unlock(&(pool->lock)) != 0) {
         err = THREADPOOL_LOCK_FAILURE;
     }
 
-    // 等待所有线程结束
-    for (i = 0; i < pool->started; i++) {
-        if (pthread_join(pool->threads[i], NULL) != 0) {
-            err = THREADPOOL_THREAD_FAILURE;
-        }
+    // 等待所有线程结束（包括已退出、尚未回收的线程）
+    if (threadpool_join_all(pool) != 0) {
+        err = THREADPOOL_THREAD_FAILURE;
     }
+    pthread_attr_destroy(&pool->attr);
 
-    // 清空任务队列（立即模式下释放未执行的任务）
-    if (pthread_mutex_lock(&(pool->lock)) == 0) {
-        if (pool->queue) {
+    // 清空任务队列（立即模式下丢弃未执行的任务），此时已无工作线程。
+    // 被丢弃的任务通过取消回调通知所有者（如将 future 标记为已取消）
+    threadpool_task_t task;
+    for (i = 0; i < atomic_load(&pool->thread_count); i++) {
+        while (ws_deque_pop(pool->workers[i].deque, &task) == WS_DEQUE_SUCCESS) {
+            task_cancel(pool, &task);
+        }
+    }
+    for (int p = 0; p < pool->partition_count; p++) {
+        threadpool_partition_t *part = &pool->partitions[p];
+        for (int level = 0; level < THREADPOOL_PRIORITY_LEVELS; level++) {
+            ring_queue_t *overflow = part->overflow[level];
+            while (part->queue[level] && ring_queue_mpmc_dequeue(part->queue[level], &task) == RING_QUEUE_SUCCESS) {
+                task_cancel(pool, &task);
+            }
             void *elem = NULL;
-            while (!ring_queue_is_empty(pool->queue)) {
-                if (ring_queue_peek(pool->queue, &elem) == RING_QUEUE_SUCCESS && elem) {
-                    // 出队
-                    ring_queue_dequeue(pool->queue);
-                    // 释放任务
-                    threadpool_task_t *t = (threadpool_task_t *)elem;
-                    if (pool->task_pool) {
-                        switch (t->alloc_type) {
-                            case 1:
-                                memory_pool_free_fixed(pool->task_pool, t);
-#ifdef DEBUG
-                                pool->dbg_destroy_free_pool_fixed++;
-#endif
-                                break;
-                            case 2:
-                                memory_pool_free(pool->task_pool, t);
-#ifdef DEBUG
-                                pool->dbg_destroy_free_pool_fixed++;
-#endif
-                                break;
-                            default:
-                                free(t);
-#ifdef DEBUG
-                                pool->dbg_destroy_free_malloc++;
-#endif
-                                break;
-                        }
-                    } else {
-                        free(t);
+            while (overflow && !ring_queue_is_empty(overflow)) {
+                if (ring_queue_peek(overflow, &elem) == RING_QUEUE_SUCCESS && elem) {
+                    // 出队、取消并释放任务
+                    ring_queue_dequeue(overflow);
+                    task_cancel(pool, &((threadpool_task_node_t *)elem)->task);
+                    task_node_free(pool, part, (threadpool_task_node_t *)elem);
 #ifdef DEBUG
-                        pool->dbg_destroy_free_malloc++;
+                    pool->dbg_destroy_free_pool_fixed++;
 #endif
-                    }
                 } else {
                     break;
                 }
             }
-            pool->queue_size = 0;
         }
-        pthread_mutex_unlock(&(pool->lock));
-    } else {
-        err = THREADPOOL_LOCK_FAILURE;
     }
+    atomic_store(&pool->queue_size, 0);
 
-    // 销毁互斥锁和条件变量
-    if (pthread_mutex_destroy(&(pool->lock)) != 0 ||
-        pthread_cond_destroy(&(pool->notify)) != 0 ||
-        pthread_cond_destroy(&(pool->empty)) != 0) {
+    // 销毁互斥锁
+    if (pthread_mutex_destroy(&(pool->lock)) != 0) {
         err = THREADPOOL_LOCK_FAILURE;
     }
 
     // DEBUG: 打印统计信息
 #ifdef DEBUG
-    fprintf(stderr, "[threadpool][DEBUG] alloc_fixed=%zu alloc_pool=%zu alloc_malloc=%zu\n",
-        pool->dbg_alloc_fixed, pool->dbg_alloc_pool, pool->dbg_alloc_malloc);
+    threadpool_stats_t stats;
+    threadpool_get_stats(pool, &stats);
+    fprintf(stderr, "[threadpool][DEBUG] alloc_fixed=%llu alloc_pool=%llu alloc_malloc=%llu\n",
+        (unsigned long long)stats.alloc_fixed, (unsigned long long)stats.alloc_pool,
+        (unsigned long long)stats.alloc_malloc);
     fprintf(stderr, "[threadpool][DEBUG] free_pool_or_fixed=%zu free_malloc=%zu\n",
         pool->dbg_free_pool_fixed, pool->dbg_free_malloc);
-    fprintf(stderr, "[threadpool][DEBUG] destroy_free_pool_or_fixed=%zu destroy_free_malloc=%zu\n",
-        pool->dbg_destroy_free_pool_fixed, pool->dbg_destroy_free_malloc);
+    fprintf(stderr, "[threadpool][DEBUG] destroy_free=%zu\n",
+        pool->dbg_destroy_free_pool_fixed);
+    fprintf(stderr, "[threadpool][DEBUG] local_push=%llu steal=%llu cancelled=%llu\n",
+        (unsigned long long)stats.local_pushes, (unsigned long long)stats.steals,
+        (unsigned long long)stats.cancelled);
 #endif
 
     // 释放内存
     if (pool->threads) {
         free(pool->threads);
     }
-    if (pool->queue) {
-        ring_queue_destroy(pool->queue);
+    if (pool->workers) {
+        for (i = 0; i < pool->capacity; i++) {
+            if (pool->workers[i].deque) {
+                ws_deque_destroy(pool->workers[i].deque);
+            }
+            if (pool->workers[i].inbox) {
+                ring_queue_spsc_destroy(pool->workers[i].inbox);
+            }
+            free(pool->workers[i].latency);
+            free(pool->workers[i].trace);
+        }
+        free(pool->workers);
     }
-    if (pool->task_pool) {
-        memory_pool_destroy(pool->task_pool);
+    free(pool->ext_stats);
+    threadpool_free_ext_trace(pool);
+    if (threadpool_free_partitions(pool) != 0) {
+        err = THREADPOOL_LOCK_FAILURE;
     }
-    free(pool);
+    // 尚有未释放的 future 时，task_pool 与结构体由最后一个 future 释放
+    threadpool_release(pool);
 
     return err;
-}
\ No newline at end of file
+}
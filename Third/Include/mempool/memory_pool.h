@@ -42,10 +42,23 @@ extern "C" {
 // 内存对齐优化
 #define DEFAULT_ALIGNMENT 64    // CPU缓存行大小
 // 最小块大小
-#define MIN_BLOCK_SIZE 32      // 减少碎片
+#define MIN_BLOCK_SIZE 64      // 减少碎片；须不小于块头部 memory_block_t，否则切分出的空闲块头部会越界
 // 最大固定大小类别
 #define MAX_SIZE_CLASSES 16    // 支持的固定大小数量
 #define PAGE_SIZE 4096
+// 固定大小类别查找表：覆盖的最大尺寸（按 16 字节粒度），更大的尺寸线性查找
+#define MP_CLASS_LUT_MAX  4096
+#define MP_CLASS_LUT_SIZE ((MP_CLASS_LUT_MAX >> 4) + 1)
+// 线程本地缓存（每线程每类别一个 magazine）
+#define MP_TCACHE_POOLS   4     // 每个线程同时缓存的内存池数量，超出时轮换淘汰
+#define MP_TCACHE_BATCH   32    // 每次与共享类别链表交换的块数
+#define MP_TCACHE_MAX     64    // 每个类别缓存的块数上限，超出时归还一批
+// 每 CPU 缓存（rseq，仅 x86-64 Linux + glibc 2.35 以上）
+#define MP_PERCPU_SLOTS   32    // 每个 CPU 每个类别的槽位数
+#define MP_PERCPU_BATCH   16    // 槽位空/满时与共享类别链表交换的块数
+
+#define MP_WARMUP_CHUNK       ((size_t)64 << 20) // 并行预热的分块大小
+#define MP_WARMUP_MAX_THREADS 256
 
 // 标志位
 #define MB_FLAG_PREV_FREE  0x1    // 前一个物理块是空闲块（通用块）
@@ -53,30 +66,48 @@ extern "C" {
 #define MB_FLAG_SIZECLASS  0x4    // 属于固定大小类别管理（不参与通用合并）
 
 // 内存块头部结构（紧凑 + 复用）：
-// 空闲块: union.next 用作空闲链指针；已分配块: union.prev_size 记录前一物理块大小(用于 O(1) 反向合并)
+// 空闲块: union.next/prev 串成双向空闲链（O(1) 摘除）；已分配块: union.prev_size 记录前一物理块大小(用于 O(1) 反向合并)
 typedef struct memory_block {
     union {
         struct memory_block* next; // 空闲链表指针（仅当 MB_FLAG_FREE=1 时有效）
         uint32_t prev_size;        // 前一个物理块大小（仅当 MB_FLAG_FREE=0 且 MB_FLAG_PREV_FREE=1 时有效）
     } u;
+    struct memory_block* prev;     // 空闲链表前驱（仅当 MB_FLAG_FREE=1 时有效）
     size_t size;                   // 当前块大小（含头部，已按 alignment 对齐）
     uint32_t flags;                // 标志位（替换原 padding）
     uint32_t magic;                // 魔数，用于检测内存损坏（可在 RELEASE 构建裁剪）
-    // 红黑树指针（仅在通用空闲树中使用，减少额外结构体分配）
+    // 红黑树指针（仅在通用空闲树中使用，减少额外结构体分配；TLSF 引擎下 rb_left/rb_right 用作分级链表的 next/prev）
     struct memory_block* rb_left;
     struct memory_block* rb_right;
     struct memory_block* rb_parent;
     unsigned char rb_color; // 0=红,1=黑
 } memory_block_t;
 
+// 通用分配的空闲块索引引擎
+typedef enum {
+    MP_ENGINE_RBTREE = 0,          // 红黑树 best-fit，O(log n)
+    MP_ENGINE_TLSF                 // 两级分离适配（Two-Level Segregated Fit），O(1) 分配/释放
+} mp_engine_t;
+
+// 池内存的页类型；大页不可用时逐级回退（1GB -> 2MB -> 透明大页 -> 普通页）
+typedef enum {
+    MP_PAGES_DEFAULT = 0,          // 普通 4K 页
+    MP_PAGES_THP,                  // 透明大页：按 2MB 对齐映射并 madvise(MADV_HUGEPAGE)
+    MP_PAGES_HUGETLB_2M,           // MAP_HUGETLB 2MB 页（需预留 hugetlbfs 页）
+    MP_PAGES_HUGETLB_1G            // MAP_HUGETLB 1GB 页
+} mp_page_mode_t;
+
 // 固定大小类别池（用于固定大小分配优化）
 typedef struct size_class_pool {
     memory_block_t* free_blocks;   // 空闲块链表
     size_t block_size;             // 固定块大小
     size_t block_count;            // 总块数量
-    size_t used_count;             // 已使用块数
+    size_t used_count;             // 已使用块数（含线程本地缓存中的块）
 } size_class_pool_t;
 
+struct mp_tcache_entry;
+struct mp_tlsf;
+
 // 内存池结构
 typedef struct memory_pool {
     void* pool_start;              // 池起始地址
@@ -95,6 +126,22 @@ typedef struct memory_pool {
     int num_classes; // num of bins
     // 红黑树根：按 size 排序，支持 O(log n) best-fit
     memory_block_t* rb_root;       // 仅 master 使用，其他池保持 NULL
+    mp_engine_t engine;            // 空闲块索引引擎（以 master 的为准）
+    struct mp_tlsf* tlsf;          // TLSF 引擎的分级链表与位图（仅 master 使用）
+    mp_page_mode_t page_mode;      // 实际得到的页类型（回退后的结果），子池沿用
+    size_t page_size;              // 池大小与 trim 的取整粒度（大页模式下为大页大小）
+    bool populate;                 // 创建时预先缺页，子池沿用
+    int numa_node;                 // 内存优先放置的 NUMA 节点（-1 表示不绑定），子池继承
+    // 类别查找表：按尺寸向上取整到 16 字节的粒度索引
+    uint8_t class_lut[MP_CLASS_LUT_SIZE]; // 用户尺寸 -> 类别（alloc_fixed）
+    uint8_t block_lut[MP_CLASS_LUT_SIZE]; // 块大小 -> 类别（free_fixed）
+    // 线程本地缓存
+    bool thread_cache;             // 固定大小类别是否启用线程本地缓存（仅线程安全的主池）
+    uint64_t tcache_id;            // 缓存代号：reset 后更换，使各线程缓存的旧块失效
+    struct mp_tcache_entry* tcache_list; // 挂接到本池的线程缓存（受全局缓存锁保护）
+    // 每 CPU 缓存：[CPU][类别] 的槽位数组，NULL 表示未启用
+    void* percpu_slabs;
+    uint32_t percpu_cpus;          // 槽位数组覆盖的 CPU 数量（编号更大的 CPU 走加锁路径）
 } memory_pool_t;
 
 // 内存池配置
@@ -105,6 +152,13 @@ typedef struct pool_config {
     bool enable_size_classes;      // 是否启用固定大小池
     size_t* size_class_sizes;      // 固定大小数组
     int num_size_classes;          // 固定大小数量
+    bool numa_bind;                // 是否将池内存优先放置到 numa_node（mbind MPOL_PREFERRED，失败时忽略）
+    int numa_node;                 // NUMA 节点编号（numa_bind 为 true 时有效）
+    bool thread_cache;             // 固定大小类别使用线程本地缓存（需 thread_safe，类别须在并发使用前添加）
+    bool percpu_cache;             // 固定大小类别使用每 CPU 缓存（需 thread_safe；rseq 不可用时回退到线程本地缓存或加锁路径）
+    mp_engine_t engine;            // 通用分配的空闲块索引引擎，默认红黑树
+    mp_page_mode_t page_mode;      // 池内存的页类型，池大小按该页大小向上取整
+    bool populate;                 // 创建时预先缺页（MAP_POPULATE / MADV_POPULATE_WRITE），在 NUMA 绑定之后进行
 } pool_config_t;
 
 // 内存池创建和销毁
@@ -126,7 +180,16 @@ size_t memory_pool_get_block_size(memory_pool_t* pool, void* ptr);
 
 // 性能优化
 void memory_pool_warmup(memory_pool_t* pool);
+// 并行预热：整条池链切成按页对齐的分块（MP_WARMUP_CHUNK，1GB 大页时为一页），
+// 由调用线程和 threads - 1 个临时线程分摊缺页，成功返回0。不要与 trim 或 destroy 并发调用
+int memory_pool_warmup_parallel(memory_pool_t* pool, int threads);
+// 供外部线程池调度：分块总数，以及预热其中一块（可在任意线程上并发调用）
+size_t memory_pool_warmup_chunks(memory_pool_t* pool);
+void memory_pool_warmup_chunk(memory_pool_t* pool, size_t index);
 void memory_pool_defragment(memory_pool_t* pool);
+// 把内存还给操作系统：对空闲块页对齐的内部区间 madvise(MADV_DONTNEED)，并解除完全空闲子池的映射；
+// 返回这两部分覆盖的字节数（可能包含本就未驻留的页）。持池锁执行，可在突发负载后按需调用
+size_t memory_pool_trim(memory_pool_t* pool);
 
 // 调试
 bool memory_pool_validate(memory_pool_t* pool);
@@ -135,6 +198,8 @@ bool memory_pool_validate(memory_pool_t* pool);
 int memory_pool_add_size_class(memory_pool_t* pool, size_t size, size_t count);
 void* memory_pool_alloc_fixed(memory_pool_t* pool, size_t size);
 void memory_pool_free_fixed(memory_pool_t* pool, void* ptr);
+// 每 CPU 缓存在当前环境是否可用（编译平台支持且 glibc 已为线程注册 rseq）
+bool memory_pool_percpu_available(void);
 
 // 错误码
 typedef enum {
@@ -0,0 +1,47 @@
+#ifndef __RING_QUEUE_MPMC_H__
+#define __RING_QUEUE_MPMC_H__
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "ring_queue.h"
+
+// 多生产者多消费者无锁有界环形队列（Vyukov 算法）
+// 每个槽位带序列号：seq == pos 表示可写，seq == pos + 1 表示可读。
+// 容量为2的幂，用掩码代替取模；head/tail 各占独立缓存行，避免伪共享。
+// 元素按值拷贝存放，elem_size 在创建时指定（存放指针时传 sizeof(void*)）。
+typedef struct {
+    _Alignas(64) _Atomic size_t enqueue_pos;    // 生产者位置
+    _Alignas(64) _Atomic size_t dequeue_pos;    // 消费者位置
+    _Alignas(64) unsigned char *cells;          // 槽位数组（序列号 + 元素）
+    size_t capacity;                            // 容量（2的幂）
+    size_t mask;                                // capacity - 1
+    size_t elem_size;                           // 元素大小
+    size_t cell_stride;                         // 单个槽位字节数
+} ring_queue_mpmc_t;
+
+// 创建无锁队列（capacity 向上取整到2的幂）
+extern ring_queue_mpmc_t* ring_queue_mpmc_create(size_t capacity, size_t elem_size);
+
+// 销毁无锁队列（不负责释放元素）
+extern void ring_queue_mpmc_destroy(ring_queue_mpmc_t *queue);
+
+// 入队操作，满时返回 RING_QUEUE_FULL
+extern ring_queue_status_t ring_queue_mpmc_enqueue(ring_queue_mpmc_t *queue, const void *element);
+
+// 出队操作，把队首元素拷贝到 element，空时返回 RING_QUEUE_EMPTY
+extern ring_queue_status_t ring_queue_mpmc_dequeue(ring_queue_mpmc_t *queue, void *element);
+
+// 批量入队：一次 CAS 预占连续槽位，最多写入 count 个元素（elements 为连续数组），
+// 返回实际写入数量
+extern size_t ring_queue_mpmc_enqueue_bulk(ring_queue_mpmc_t *queue, const void *elements, size_t count);
+
+// 判断队列是否为空（并发下为近似值）
+extern int ring_queue_mpmc_is_empty(ring_queue_mpmc_t *queue);
+
+// 获取队列当前元素数量（并发下为近似值）
+extern size_t ring_queue_mpmc_size(ring_queue_mpmc_t *queue);
+
+// 获取队列容量
+extern size_t ring_queue_mpmc_capacity(const ring_queue_mpmc_t *queue);
+
+#endif /* __RING_QUEUE_MPMC_H__ */
@@ -0,0 +1,46 @@
+#ifndef __RING_QUEUE_SPSC_H__
+#define __RING_QUEUE_SPSC_H__
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "ring_queue.h"
+
+// 单生产者单消费者无锁环形队列
+// 生产者只写 tail，消费者只写 head，二者以 acquire/release 配对发布；
+// 每一端缓存对端索引，只有缓存值显示满/空时才重新读取对端缓存行。
+// 批量接口一次发布 N 个元素，只需一次原子写。
+typedef struct {
+    _Alignas(64) _Atomic size_t head;   // 消费者索引
+    size_t cached_tail;                 // 消费者缓存的 tail
+    _Alignas(64) _Atomic size_t tail;   // 生产者索引
+    size_t cached_head;                 // 生产者缓存的 head
+    _Alignas(64) void **buffer;         // 存储元素的数组
+    size_t capacity;                    // 容量（2的幂）
+    size_t mask;                        // capacity - 1
+} ring_queue_spsc_t;
+
+// 创建队列（capacity 向上取整到2的幂）
+extern ring_queue_spsc_t* ring_queue_spsc_create(size_t capacity);
+
+// 销毁队列（不负责释放元素）
+extern void ring_queue_spsc_destroy(ring_queue_spsc_t *queue);
+
+// 入队操作（仅生产者线程调用）
+extern ring_queue_status_t ring_queue_spsc_enqueue(ring_queue_spsc_t *queue, void *element);
+
+// 出队操作（仅消费者线程调用）
+extern ring_queue_status_t ring_queue_spsc_dequeue(ring_queue_spsc_t *queue, void **element);
+
+// 批量入队：最多写入 count 个元素，返回实际写入数量（仅生产者线程调用）
+extern size_t ring_queue_spsc_enqueue_bulk(ring_queue_spsc_t *queue, void *const *elements, size_t count);
+
+// 批量出队：最多取出 count 个元素，返回实际取出数量（仅消费者线程调用）
+extern size_t ring_queue_spsc_dequeue_bulk(ring_queue_spsc_t *queue, void **elements, size_t count);
+
+// 获取队列当前元素数量（并发下为近似值）
+extern size_t ring_queue_spsc_size(ring_queue_spsc_t *queue);
+
+// 获取队列容量
+extern size_t ring_queue_spsc_capacity(const ring_queue_spsc_t *queue);
+
+#endif /* __RING_QUEUE_SPSC_H__ */
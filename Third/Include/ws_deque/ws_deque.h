@@ -0,0 +1,53 @@
+#ifndef __WS_DEQUE_H__
+#define __WS_DEQUE_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// 工作窃取双端队列状态
+typedef enum {
+    WS_DEQUE_SUCCESS = 0,       // 操作成功
+    WS_DEQUE_EMPTY = 1,         // 队列为空
+    WS_DEQUE_FULL = 2,          // 队列已满
+    WS_DEQUE_ABORT = 3,         // 窃取与其他线程竞争失败，可重试
+    WS_DEQUE_ERROR = -1         // 一般错误
+} ws_deque_status_t;
+
+// Chase-Lev 工作窃取双端队列（固定容量，容量为2的幂）
+// 所有者线程在 bottom 端 push/pop（LIFO），其他线程在 top 端 steal（FIFO）。
+// 元素按值拷贝存放在槽位中，elem_size 在创建时指定。
+typedef struct {
+    _Alignas(64) _Atomic int64_t top;   // 窃取端索引（多线程竞争）
+    _Alignas(64) _Atomic int64_t bottom;// 所有者端索引（仅所有者写）
+    _Alignas(64) unsigned char *buffer; // 槽位数组
+    size_t capacity;                    // 容量（2的幂）
+    size_t mask;                        // capacity - 1
+    size_t elem_size;                   // 元素大小
+} ws_deque_t;
+
+// 创建双端队列（capacity 向上取整到2的幂）
+extern ws_deque_t* ws_deque_create(size_t capacity, size_t elem_size);
+
+// 销毁双端队列
+extern void ws_deque_destroy(ws_deque_t *deque);
+
+// 所有者入队（bottom 端）
+extern ws_deque_status_t ws_deque_push(ws_deque_t *deque, const void *element);
+
+// 所有者出队（bottom 端，后进先出）
+extern ws_deque_status_t ws_deque_pop(ws_deque_t *deque, void *element);
+
+// 窃取（top 端，先进先出），任意线程可调用
+extern ws_deque_status_t ws_deque_steal(ws_deque_t *deque, void *element);
+
+// 获取当前元素数量（并发下为近似值）
+extern size_t ws_deque_size(ws_deque_t *deque);
+
+// 判断队列是否为空（并发下为近似值）
+extern int ws_deque_is_empty(ws_deque_t *deque);
+
+// 获取队列容量
+extern size_t ws_deque_capacity(const ws_deque_t *deque);
+
+#endif /* __WS_DEQUE_H__ */
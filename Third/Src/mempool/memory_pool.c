@@ -2,13 +2,98 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
+#include <linux/mempolicy.h>
 #include <stdio.h>
 #include <assert.h>
 
+// 每 CPU 缓存依赖 glibc 注册的 rseq 区域与 x86-64 汇编临界区
+#if defined(__x86_64__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 35))
+#include <sys/rseq.h>
+#define MP_HAVE_RSEQ 1
+#else
+#define MP_HAVE_RSEQ 0
+#endif
+
 // 线程局部错误码
 static __thread pool_error_t g_last_error = POOL_OK;
 
+// 线程本地缓存：每个类别一个 magazine（复用块头 u.next 串成单链表）
+typedef struct mp_magazine {
+    memory_block_t* head;
+    uint32_t count;
+} mp_magazine_t;
+
+// 线程对某个内存池的缓存槽位
+typedef struct mp_tcache_entry {
+    memory_pool_t* pool;           // 所属池（池销毁时置 NULL；跨线程写入，使用原子访问）
+    uint64_t id;                   // 缓存代号，与池的 tcache_id 不一致时丢弃缓存的块
+    struct mp_tcache_entry* prev;  // 池的挂接链表
+    struct mp_tcache_entry* next;
+    mp_magazine_t mags[MAX_SIZE_CLASSES];
+} mp_tcache_entry_t;
+
+typedef struct mp_tcache {
+    mp_tcache_entry_t entries[MP_TCACHE_POOLS];
+    unsigned int victim;           // 槽位用满时轮换淘汰
+} mp_tcache_t;
+
+// 全局缓存锁保护各池的挂接链表与槽位的挂接/摘除；加锁顺序为 全局缓存锁 -> pool->mutex
+static pthread_mutex_t g_tcache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_tcache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_tcache_key;
+static uint64_t g_tcache_next_id = 1;
+static __thread mp_tcache_t* tls_tcache = NULL;
+
+// 每 CPU 槽位数组：count 为已用槽位数，只在所属 CPU 上通过 rseq 临界区修改
+typedef struct mp_cpu_slab {
+    uint64_t count;
+    memory_block_t* slots[MP_PERCPU_SLOTS];
+} mp_cpu_slab_t;
+
+#define MP_PERCPU_STRIDE (sizeof(mp_cpu_slab_t) * MAX_SIZE_CLASSES) // 每个 CPU 的槽位数组大小
+
+#define MP_CLASS_NONE 0xFF         // 查找表：没有匹配的类别
+#define MP_CLASS_SCAN 0xFE         // 查找表：该粒度内有类别边界，需要线性查找
+
+// 地址 -> 所属池 的全局基数映射：48 位地址空间按 64KB 粒度分三级（12/10/10 位）索引。
+// 池映射按粒度对齐，因此每个粒度至多属于一个池；叶子节点只增不减，查找无需加锁
+#define MP_OWNER_SHIFT     16
+#define MP_OWNER_GRANULE   ((size_t)1 << MP_OWNER_SHIFT)
+#define MP_OWNER_ADDR_BITS 48
+#define MP_OWNER_L1_BITS   12
+#define MP_OWNER_L2_BITS   10
+#define MP_OWNER_L3_BITS   10
+
+// 大页大小
+#define MP_HUGE_2M         ((size_t)2 << 20)
+#define MP_HUGE_1G         ((size_t)1 << 30)
+
+typedef struct mp_owner_leaf {
+    memory_pool_t* pools[1 << MP_OWNER_L3_BITS];
+} mp_owner_leaf_t;
+
+typedef struct mp_owner_node {
+    mp_owner_leaf_t* leaves[1 << MP_OWNER_L2_BITS];
+} mp_owner_node_t;
+
+static mp_owner_node_t* g_owner_map[1 << MP_OWNER_L1_BITS];
+static pthread_mutex_t g_owner_lock = PTHREAD_MUTEX_INITIALIZER; // 仅保护写入（注册/注销）
+
+// TLSF：一级按 2 的幂分档，二级把每档再线性分成 16 份；小于 TLSF_SMALL 的尺寸统一放在一级 0 档，按 16 字节线性分
+#define TLSF_SL_LOG2   4
+#define TLSF_SL_COUNT  (1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT  (TLSF_SL_LOG2 + 4)
+#define TLSF_SMALL     ((size_t)1 << TLSF_FL_SHIFT)
+#define TLSF_FL_COUNT  (64 - TLSF_FL_SHIFT + 1)
+
+typedef struct mp_tlsf {
+    uint64_t fl_bitmap;                                   // 一级位图：对应档位有非空链表
+    uint32_t sl_bitmap[TLSF_FL_COUNT];                    // 二级位图
+    memory_block_t* heads[TLSF_FL_COUNT][TLSF_SL_COUNT];  // 分级空闲链表表头
+} mp_tlsf_t;
+
 // 内部函数声明
 static inline size_t align_size(size_t size, size_t alignment);
 static inline bool is_power_of_two(size_t n);
@@ -17,10 +102,11 @@ static bool validate_block(memory_block_t* block);
 static void insert_free_block(memory_pool_t* pool, memory_block_t* block);
 static memory_pool_t* create_child_pool(memory_pool_t* root, size_t min_size);
 static memory_block_t* find_best_fit_chain(memory_pool_t* root, memory_pool_t** owner_pool, size_t size);
+static memory_pool_t* owner_map_get(const void* ptr);
 // RB-tree (按 size, 次键地址) 管理空闲块，O(log n) best-fit
 static void rb_insert(memory_pool_t* pool, memory_block_t* node);
 static void rb_remove(memory_pool_t* pool, memory_block_t* node);
-static memory_block_t* rb_find_best_fit(memory_pool_t* pool, size_t size, memory_pool_t** owner_pool);
+static memory_block_t* rb_find_best_fit(memory_pool_t* master, size_t size);
 static void rb_init_node(memory_block_t* n) { n->rb_left = n->rb_right = n->rb_parent = NULL; n->rb_color = 0; }
 
 // 旋转与修复
@@ -148,18 +234,102 @@ static void rb_remove(memory_pool_t* pool, memory_block_t* z) {
         if (x) x->rb_color = 1;
     }
 }
-static memory_block_t* rb_find_best_fit(memory_pool_t* root, size_t size, memory_pool_t** owner_pool) {
-    if (!root) return NULL;
-    memory_pool_t* master = root->master ? root->master : root;
+static memory_block_t* rb_find_best_fit(memory_pool_t* master, size_t size) {
     memory_block_t* cur = master->rb_root; memory_block_t* candidate = NULL;
     while (cur) {
         if (cur->size == size) { candidate = cur; break; }
         if (cur->size > size) { candidate = cur; cur = cur->rb_left; } else cur = cur->rb_right;
     }
+    return candidate;
+}
+
+// TLSF 档位映射：尺寸 -> (一级, 二级)
+static inline void tlsf_mapping(size_t size, int* fl, int* sl) {
+    if (size < TLSF_SMALL) {
+        *fl = 0;
+        *sl = (int)(size >> (TLSF_FL_SHIFT - TLSF_SL_LOG2));
+    } else {
+        int f = 63 - __builtin_clzll((unsigned long long)size);
+        *fl = f - (TLSF_FL_SHIFT - 1);
+        *sl = (int)((size >> (f - TLSF_SL_LOG2)) & (TLSF_SL_COUNT - 1));
+    }
+}
+
+// 放入对应档位链表表头；链接复用 rb_left(next)/rb_right(prev)
+static void tlsf_insert(mp_tlsf_t* t, memory_block_t* block) {
+    int fl, sl;
+    tlsf_mapping(block->size, &fl, &sl);
+    memory_block_t* head = t->heads[fl][sl];
+    block->rb_left = head;
+    block->rb_right = NULL;
+    block->rb_parent = NULL;
+    if (head) head->rb_right = block;
+    t->heads[fl][sl] = block;
+    t->fl_bitmap |= 1ULL << fl;
+    t->sl_bitmap[fl] |= 1U << sl;
+}
+
+// 从档位链表摘除（块尺寸须与插入时一致）
+static void tlsf_remove(mp_tlsf_t* t, memory_block_t* block) {
+    int fl, sl;
+    tlsf_mapping(block->size, &fl, &sl);
+    if (block->rb_right) block->rb_right->rb_left = block->rb_left;
+    else if (t->heads[fl][sl] == block) t->heads[fl][sl] = block->rb_left;
+    else { MP_LOG("tlsf_remove skip: node %p not in list", (void*)block); return; }
+    if (block->rb_left) block->rb_left->rb_right = block->rb_right;
+    block->rb_left = block->rb_right = NULL;
+    if (!t->heads[fl][sl]) {
+        t->sl_bitmap[fl] &= ~(1U << sl);
+        if (!t->sl_bitmap[fl]) t->fl_bitmap &= ~(1ULL << fl);
+    }
+}
+
+// 查找不小于 size 的空闲块：先把 size 向上取整到下一档，使该档链表中任一块都满足要求，再按位图找最近的非空档
+static memory_block_t* tlsf_find(mp_tlsf_t* t, size_t size) {
+    if (size < TLSF_SMALL) {
+        size += ((size_t)1 << (TLSF_FL_SHIFT - TLSF_SL_LOG2)) - 1;
+    } else {
+        int f = 63 - __builtin_clzll((unsigned long long)size);
+        size += ((size_t)1 << (f - TLSF_SL_LOG2)) - 1;
+    }
+    int fl, sl;
+    tlsf_mapping(size, &fl, &sl);
+    uint32_t sl_map = t->sl_bitmap[fl] & (~0U << sl);
+    if (!sl_map) {
+        uint64_t fl_map = (fl + 1 < 64) ? t->fl_bitmap & (~0ULL << (fl + 1)) : 0;
+        if (!fl_map) return NULL;
+        fl = __builtin_ctzll(fl_map);
+        sl_map = t->sl_bitmap[fl];
+    }
+    return t->heads[fl][__builtin_ctz(sl_map)];
+}
+
+// 空闲块索引：按主池选择的引擎分派
+static void index_insert(memory_pool_t* pool, memory_block_t* block) {
+    memory_pool_t* master = pool->master ? pool->master : pool;
+    if (master->engine == MP_ENGINE_TLSF) tlsf_insert(master->tlsf, block); else rb_insert(master, block);
+}
+
+static void index_remove(memory_pool_t* pool, memory_block_t* block) {
+    memory_pool_t* master = pool->master ? pool->master : pool;
+    if (master->engine == MP_ENGINE_TLSF) tlsf_remove(master->tlsf, block); else rb_remove(master, block);
+}
+
+// 清空索引（reset 后重新插入各池的初始块）
+static void index_clear(memory_pool_t* master) {
+    master->rb_root = NULL;
+    if (master->tlsf) memset(master->tlsf, 0, sizeof(mp_tlsf_t));
+}
+
+// 取出一个不小于 size 的空闲块并确定其所属池（查地址映射）
+static memory_block_t* index_take(memory_pool_t* root, size_t size, memory_pool_t** owner_pool) {
+    if (!root) return NULL;
+    memory_pool_t* master = root->master ? root->master : root;
+    memory_block_t* candidate = (master->engine == MP_ENGINE_TLSF) ? tlsf_find(master->tlsf, size)
+                                                                   : rb_find_best_fit(master, size);
     if (!candidate) return NULL;
-    // 找到后需确定其所属池：通过遍历链判断地址范围
-    memory_pool_t* p = master; while (p) { if ((char*)candidate >= (char*)p->pool_start && (char*)candidate < (char*)p->pool_start + p->pool_size) { *owner_pool = p; break; } p = p->next; }
-    rb_remove(master, candidate);
+    *owner_pool = owner_map_get(candidate);
+    index_remove(master, candidate);
     candidate->flags &= ~MB_FLAG_FREE;
     return candidate;
 }
@@ -227,6 +397,8 @@ static inline memory_block_t* next_physical_block(memory_pool_t* pool, memory_bl
 static inline void set_next_prev_free(memory_pool_t* pool, memory_block_t* free_blk) {
     memory_block_t* nxt = next_physical_block(pool, free_blk);
     if (!nxt) return;
+    // size-class 块不参与合并，且空闲时 u.next 是类别链表/线程缓存的链接，不能覆盖；通用空闲块的 u.next 同理
+    if (nxt->flags & (MB_FLAG_SIZECLASS | MB_FLAG_FREE)) return;
     // 只有在后继块不是空闲列表中的 size-class 专属块时才安全；暂未区分，保持通用逻辑
     nxt->flags |= MB_FLAG_PREV_FREE;
     // prev_size 仅在后继块“当前不在通用 free_list”或者需要反向合并时使用
@@ -239,23 +411,481 @@ static inline void clear_next_prev_free(memory_pool_t* pool, memory_block_t* blk
     nxt->flags &= ~MB_FLAG_PREV_FREE;
 }
 
-// 从空闲链表中移除（地址排序的单链表）
+// 从双向空闲链表摘除，O(1)；块不在本池链表中时返回 false
+static bool unlink_free_block(memory_pool_t* pool, memory_block_t* block) {
+    if (!block->prev && pool->free_list != block) {
+        MP_LOG("unlink_free_block: target %p not found in free list pool=%p", (void*)block, (void*)pool);
+        return false;
+    }
+    if (block->prev) block->prev->u.next = block->u.next; else pool->free_list = block->u.next;
+    if (block->u.next) block->u.next->prev = block->prev;
+    block->u.next = block->prev = NULL;
+    return true;
+}
+
+// 从空闲结构中移除（链表与主池红黑树）
 static void remove_free_block(memory_pool_t* pool, memory_block_t* block) {
     if (!pool->free_list || !block) return;
     memory_pool_t* master = pool->master ? pool->master : pool;
     MP_ASSERT(block->flags & MB_FLAG_FREE, "remove_free_block: block not marked FREE");
-    if (pool->free_list == block) {
-        pool->free_list = block->u.next;
-        if (block->flags & MB_FLAG_FREE) rb_remove(master, block);
-        return;    
-    }
-    memory_block_t* cur = pool->free_list;
-    while (cur->u.next && cur->u.next != block) cur = cur->u.next;
-    if (cur->u.next == block) {
-        cur->u.next = block->u.next;
-        if (block->flags & MB_FLAG_FREE) rb_remove(master, block);
+    if (unlink_free_block(pool, block) && (block->flags & MB_FLAG_FREE)) {
+        index_remove(master, block);
+    }
+}
+
+// 重建类别查找表（创建时或持锁添加类别后调用）。
+// 粒度 g 覆盖尺寸 ((g-1)*16, g*16]；粒度内有类别边界时标记为线性查找
+static void rebuild_class_lut(memory_pool_t* pool) {
+    for (size_t g = 0; g < MP_CLASS_LUT_SIZE; g++) {
+        size_t lo = (g == 0) ? 0 : (g - 1) * 16 + 1;
+        size_t hi = g * 16;
+        uint8_t by_size = MP_CLASS_NONE, by_block = MP_CLASS_NONE;
+        for (int i = 0; i < pool->num_classes; i++) {
+            size_t cs = pool->class_sizes[i];
+            size_t bs = pool->size_classes[i].block_size;
+            if (by_size != MP_CLASS_SCAN) {
+                if (cs >= lo && cs < hi) {
+                    by_size = MP_CLASS_SCAN;
+                } else if (cs >= hi && by_size == MP_CLASS_NONE) {
+                    by_size = (uint8_t)i;
+                }
+            }
+            if (bs >= lo && bs <= hi && by_block != MP_CLASS_SCAN) {
+                if (by_block == MP_CLASS_NONE) {
+                    by_block = (uint8_t)i;
+                } else if (pool->size_classes[by_block].block_size != bs) {
+                    by_block = MP_CLASS_SCAN;
+                }
+            }
+        }
+        pool->class_lut[g] = by_size;
+        pool->block_lut[g] = by_block;
+    }
+}
+
+// 按用户尺寸查找类别：第一个 class_sizes[i] >= size 的类别，没有返回 -1
+static inline int size_class_index(memory_pool_t* pool, size_t size) {
+    if (size <= MP_CLASS_LUT_MAX) {
+        uint8_t c = pool->class_lut[(size + 15) >> 4];
+        if (c != MP_CLASS_SCAN) {
+            return (c == MP_CLASS_NONE) ? -1 : c;
+        }
+    }
+    for (int i = 0; i < pool->num_classes; i++) {
+        if (size <= pool->class_sizes[i]) return i;
+    }
+    return -1;
+}
+
+// 按块大小查找类别：第一个 block_size 相等的类别，没有返回 -1
+static inline int block_class_index(memory_pool_t* pool, size_t block_size) {
+    if (block_size <= MP_CLASS_LUT_MAX) {
+        uint8_t c = pool->block_lut[(block_size + 15) >> 4];
+        if (c != MP_CLASS_SCAN) {
+            return (c != MP_CLASS_NONE && pool->size_classes[c].block_size == block_size) ? c : -1;
+        }
+    }
+    for (int i = 0; i < pool->num_classes; i++) {
+        if (block_size == pool->size_classes[i].block_size) return i;
+    }
+    return -1;
+}
+
+// 把 magazine 中前 n 块归还到共享类别链表（n 不超过 count）
+static void tcache_flush(memory_pool_t* pool, int ci, mp_magazine_t* m, uint32_t n) {
+    if (n == 0) return;
+    memory_block_t* first = m->head;
+    memory_block_t* last = first;
+    for (uint32_t k = 1; k < n; k++) last = last->u.next;
+    m->head = last->u.next;
+    m->count -= n;
+
+    pthread_mutex_lock(&pool->mutex);
+    size_class_pool_t* class_pool = &pool->size_classes[ci];
+    last->u.next = class_pool->free_blocks;
+    class_pool->free_blocks = first;
+    class_pool->used_count -= n;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// 从共享类别链表一次取一批块放入 magazine
+static void tcache_refill(memory_pool_t* pool, int ci, mp_magazine_t* m) {
+    pthread_mutex_lock(&pool->mutex);
+    size_class_pool_t* class_pool = &pool->size_classes[ci];
+    while (m->count < MP_TCACHE_BATCH && class_pool->free_blocks) {
+        memory_block_t* block = class_pool->free_blocks;
+        class_pool->free_blocks = block->u.next;
+        block->u.next = m->head;
+        m->head = block;
+        m->count++;
+        class_pool->used_count++;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// 摘除一个槽位（持有全局缓存锁，e->pool 非空）：代号一致时把缓存的块归还给池
+static void tcache_detach(mp_tcache_entry_t* e) {
+    memory_pool_t* pool = __atomic_load_n(&e->pool, __ATOMIC_RELAXED);
+    if (e->id == __atomic_load_n(&pool->tcache_id, __ATOMIC_RELAXED)) {
+        for (int i = 0; i < MAX_SIZE_CLASSES; i++) {
+            tcache_flush(pool, i, &e->mags[i], e->mags[i].count);
+        }
+    }
+    if (e->prev) e->prev->next = e->next; else pool->tcache_list = e->next;
+    if (e->next) e->next->prev = e->prev;
+    e->prev = e->next = NULL;
+    memset(e->mags, 0, sizeof(e->mags));
+    __atomic_store_n(&e->pool, NULL, __ATOMIC_RELAXED);
+}
+
+// 线程退出：归还所有缓存的块
+static void tcache_destructor(void* arg) {
+    mp_tcache_t* tc = (mp_tcache_t*)arg;
+    pthread_mutex_lock(&g_tcache_lock);
+    for (int i = 0; i < MP_TCACHE_POOLS; i++) {
+        if (__atomic_load_n(&tc->entries[i].pool, __ATOMIC_RELAXED)) {
+            tcache_detach(&tc->entries[i]);
+        }
+    }
+    pthread_mutex_unlock(&g_tcache_lock);
+    tls_tcache = NULL;
+    free(tc);
+}
+
+static void tcache_key_init(void) {
+    pthread_key_create(&g_tcache_key, tcache_destructor);
+}
+
+// 当前线程对 pool 的缓存槽位；首次使用时挂接（必要时淘汰一个槽位），失败返回 NULL
+static mp_tcache_entry_t* tcache_entry(memory_pool_t* pool) {
+    mp_tcache_t* tc = tls_tcache;
+    if (tc) {
+        for (int i = 0; i < MP_TCACHE_POOLS; i++) {
+            mp_tcache_entry_t* e = &tc->entries[i];
+            if (__atomic_load_n(&e->pool, __ATOMIC_RELAXED) == pool) {
+                uint64_t id = __atomic_load_n(&pool->tcache_id, __ATOMIC_RELAXED);
+                if (e->id != id) {
+                    // 池已 reset：缓存的块已不属于类别链表，直接丢弃
+                    memset(e->mags, 0, sizeof(e->mags));
+                    e->id = id;
+                }
+                return e;
+            }
+        }
     } else {
-        MP_LOG("remove_free_block: target %p not found in address list pool=%p", (void*)block, (void*)pool);
+        pthread_once(&g_tcache_once, tcache_key_init);
+        tc = calloc(1, sizeof(mp_tcache_t));
+        if (!tc) return NULL;
+        if (pthread_setspecific(g_tcache_key, tc) != 0) {
+            free(tc);
+            return NULL;
+        }
+        tls_tcache = tc;
+    }
+
+    mp_tcache_entry_t* e = NULL;
+    for (int i = 0; i < MP_TCACHE_POOLS && !e; i++) {
+        if (!__atomic_load_n(&tc->entries[i].pool, __ATOMIC_RELAXED)) e = &tc->entries[i];
+    }
+    pthread_mutex_lock(&g_tcache_lock);
+    if (!e) {
+        e = &tc->entries[tc->victim++ % MP_TCACHE_POOLS];
+        // 加锁后再检查：池可能刚被销毁并摘除了该槽位
+        if (__atomic_load_n(&e->pool, __ATOMIC_RELAXED)) tcache_detach(e);
+    }
+    // 槽位可能因池销毁被摘除，其中残留的块已随池释放
+    memset(e->mags, 0, sizeof(e->mags));
+    e->id = __atomic_load_n(&pool->tcache_id, __ATOMIC_RELAXED);
+    e->prev = NULL;
+    e->next = pool->tcache_list;
+    if (e->next) e->next->prev = e;
+    pool->tcache_list = e;
+    __atomic_store_n(&e->pool, pool, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&g_tcache_lock);
+    return e;
+}
+
+#if MP_HAVE_RSEQ
+// 当前线程的 rseq 区域（glibc 在线程创建时注册）
+static inline struct rseq* rseq_area(void) {
+    return (struct rseq*)((char*)__builtin_thread_pointer() + __rseq_offset);
+}
+
+// 临界区描述符放入 __rseq_cs 段；abort 处理入口前必须是注册时的签名
+#define MP_RSEQ_CS(label, start, post_commit, abort_ip) \
+    ".pushsection __rseq_cs, \"aw\"\n\t" \
+    ".balign 32\n\t" \
+    label ":\n\t" \
+    ".long 0x0, 0x0\n\t" \
+    ".quad " start ", (" post_commit " - " start "), " abort_ip "\n\t" \
+    ".popsection\n\t"
+
+#define MP_RSEQ_ABORT(abort_ip, target) \
+    ".pushsection __rseq_failure, \"ax\"\n\t" \
+    ".byte 0x0f, 0xb9, 0x3d\n\t" \
+    ".long 0x53053053\n\t" \
+    abort_ip ":\n\t" \
+    "jmp %l[" target "]\n\t" \
+    ".popsection\n\t"
+
+// 放入当前 CPU 的槽位：成功返回0，槽位已满或 CPU 编号超出范围返回1，被抢占/迁移中止返回-1
+static inline int rseq_slab_push(char* base, uint64_t cpus, memory_block_t* block) {
+    struct rseq* rs = rseq_area();
+    __asm__ goto (
+        MP_RSEQ_CS("3", "1f", "2f", "4f")
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %[rseq_cs]\n\t"
+        "1:\n\t"
+        "movl %[cpu_id], %%eax\n\t"
+        "cmpq %[cpus], %%rax\n\t"
+        "jae %l[full]\n\t"
+        "imulq %[stride], %%rax\n\t"
+        "addq %[base], %%rax\n\t"
+        "movq (%%rax), %%rcx\n\t"
+        "cmpq %[cap], %%rcx\n\t"
+        "jae %l[full]\n\t"
+        "movq %[block], 8(%%rax, %%rcx, 8)\n\t"
+        "addq $1, %%rcx\n\t"
+        "movq %%rcx, (%%rax)\n\t"   // 提交
+        "2:\n\t"
+        MP_RSEQ_ABORT("4", "aborted")
+        :
+        : [cpu_id] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs), [cpus] "r" (cpus),
+          [stride] "r" ((uint64_t)MP_PERCPU_STRIDE), [base] "r" (base),
+          [cap] "i" (MP_PERCPU_SLOTS), [block] "r" (block)
+        : "memory", "cc", "rax", "rcx"
+        : full, aborted);
+    return 0;
+full:
+    return 1;
+aborted:
+    return -1;
+}
+
+// 从当前 CPU 的槽位取出一块：成功返回0，槽位为空或 CPU 编号超出范围返回1，中止返回-1
+static inline int rseq_slab_pop(char* base, uint64_t cpus, memory_block_t** out) {
+    struct rseq* rs = rseq_area();
+    __asm__ goto (
+        MP_RSEQ_CS("3", "1f", "2f", "4f")
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %[rseq_cs]\n\t"
+        "1:\n\t"
+        "movl %[cpu_id], %%eax\n\t"
+        "cmpq %[cpus], %%rax\n\t"
+        "jae %l[empty]\n\t"
+        "imulq %[stride], %%rax\n\t"
+        "addq %[base], %%rax\n\t"
+        "movq (%%rax), %%rcx\n\t"
+        "testq %%rcx, %%rcx\n\t"
+        "jz %l[empty]\n\t"
+        "movq (%%rax, %%rcx, 8), %%rdx\n\t" // slots[count - 1]
+        "subq $1, %%rcx\n\t"
+        "movq %%rcx, (%%rax)\n\t"   // 提交
+        "2:\n\t"
+        "movq %%rdx, (%[out])\n\t"
+        MP_RSEQ_ABORT("4", "aborted")
+        :
+        : [cpu_id] "m" (rs->cpu_id), [rseq_cs] "m" (rs->rseq_cs), [cpus] "r" (cpus),
+          [stride] "r" ((uint64_t)MP_PERCPU_STRIDE), [base] "r" (base), [out] "r" (out)
+        : "memory", "cc", "rax", "rcx", "rdx"
+        : empty, aborted);
+    return 0;
+empty:
+    return 1;
+aborted:
+    return -1;
+}
+#endif
+
+// 每 CPU 缓存在当前环境是否可用
+bool memory_pool_percpu_available(void) {
+#if MP_HAVE_RSEQ
+    // __rseq_size 为0表示 glibc 未注册（如 GLIBC_TUNABLES=glibc.pthread.rseq=0）
+    return __rseq_size > 0 && (int32_t)rseq_area()->cpu_id >= 0;
+#else
+    return false;
+#endif
+}
+
+#if MP_HAVE_RSEQ
+// 类别 ci 在槽位数组中的起点（再加上 CPU 编号 * MP_PERCPU_STRIDE 即为当前 CPU 的槽位）
+static inline char* percpu_base(memory_pool_t* pool, int ci) {
+    return (char*)pool->percpu_slabs + (size_t)ci * sizeof(mp_cpu_slab_t);
+}
+
+static inline int percpu_push(memory_pool_t* pool, int ci, memory_block_t* block) {
+    int rc;
+    while ((rc = rseq_slab_push(percpu_base(pool, ci), pool->percpu_cpus, block)) < 0) {
+    }
+    return rc;
+}
+
+static inline int percpu_pop(memory_pool_t* pool, int ci, memory_block_t** block) {
+    int rc;
+    while ((rc = rseq_slab_pop(percpu_base(pool, ci), pool->percpu_cpus, block)) < 0) {
+    }
+    return rc;
+}
+
+// 每 CPU 分配：槽位为空时从共享链表取一批，一块返回，其余放入当前 CPU 的槽位
+static memory_block_t* percpu_alloc(memory_pool_t* pool, int ci) {
+    memory_block_t* block;
+    if (percpu_pop(pool, ci, &block) == 0) {
+        return block;
+    }
+
+    memory_block_t* batch[MP_PERCPU_BATCH];
+    int n = 0;
+    pthread_mutex_lock(&pool->mutex);
+    size_class_pool_t* class_pool = &pool->size_classes[ci];
+    while (n < MP_PERCPU_BATCH && class_pool->free_blocks) {
+        batch[n] = class_pool->free_blocks;
+        class_pool->free_blocks = batch[n]->u.next;
+        n++;
+    }
+    class_pool->used_count += n;
+    pthread_mutex_unlock(&pool->mutex);
+    if (n == 0) {
+        return NULL;
+    }
+
+    // batch[0] 返回给调用者；放不进槽位的（期间迁移到了已满的 CPU）压缩到 batch[1..left) 后归还共享链表
+    int left = 1;
+    for (int k = 1; k < n; k++) {
+        if (percpu_push(pool, ci, batch[k]) != 0) {
+            batch[left++] = batch[k];
+        }
+    }
+    if (left > 1) {
+        pthread_mutex_lock(&pool->mutex);
+        for (int k = 1; k < left; k++) {
+            batch[k]->u.next = class_pool->free_blocks;
+            class_pool->free_blocks = batch[k];
+        }
+        class_pool->used_count -= left - 1;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return batch[0];
+}
+
+// 每 CPU 释放：槽位已满时取出一批，连同本块一起归还共享链表
+static void percpu_free(memory_pool_t* pool, int ci, memory_block_t* block) {
+    if (percpu_push(pool, ci, block) == 0) {
+        return;
+    }
+
+    memory_block_t* batch[MP_PERCPU_BATCH + 1];
+    int n = 0;
+    while (n < MP_PERCPU_BATCH && percpu_pop(pool, ci, &batch[n]) == 0) {
+        n++;
+    }
+    batch[n++] = block;
+    pthread_mutex_lock(&pool->mutex);
+    size_class_pool_t* class_pool = &pool->size_classes[ci];
+    for (int k = 0; k < n; k++) {
+        batch[k]->u.next = class_pool->free_blocks;
+        class_pool->free_blocks = batch[k];
+    }
+    class_pool->used_count -= n;
+    pthread_mutex_unlock(&pool->mutex);
+}
+#endif
+
+// 查找地址所在粒度登记的池（可能为 NULL，调用者还需检查地址范围）
+static memory_pool_t* owner_map_get(const void* ptr) {
+    uintptr_t g = (uintptr_t)ptr >> MP_OWNER_SHIFT;
+    if (g >> (MP_OWNER_ADDR_BITS - MP_OWNER_SHIFT)) return NULL;
+    mp_owner_node_t* node = __atomic_load_n(&g_owner_map[g >> (MP_OWNER_L2_BITS + MP_OWNER_L3_BITS)], __ATOMIC_ACQUIRE);
+    if (!node) return NULL;
+    mp_owner_leaf_t* leaf = __atomic_load_n(&node->leaves[(g >> MP_OWNER_L3_BITS) & ((1 << MP_OWNER_L2_BITS) - 1)], __ATOMIC_ACQUIRE);
+    if (!leaf) return NULL;
+    return __atomic_load_n(&leaf->pools[g & ((1 << MP_OWNER_L3_BITS) - 1)], __ATOMIC_ACQUIRE);
+}
+
+// 为 [start, start + size) 覆盖的各粒度登记 owner（owner 为 NULL 即注销）；中间节点分配失败返回 false
+static bool owner_map_set(void* start, size_t size, memory_pool_t* owner) {
+    uintptr_t first = (uintptr_t)start >> MP_OWNER_SHIFT;
+    uintptr_t last = ((uintptr_t)start + size - 1) >> MP_OWNER_SHIFT;
+    if (last >> (MP_OWNER_ADDR_BITS - MP_OWNER_SHIFT)) return false;
+    bool ok = true;
+    pthread_mutex_lock(&g_owner_lock);
+    for (uintptr_t g = first; g <= last; g++) {
+        mp_owner_node_t** slot = &g_owner_map[g >> (MP_OWNER_L2_BITS + MP_OWNER_L3_BITS)];
+        mp_owner_node_t* node = *slot;
+        if (!node) {
+            if (!owner) continue;
+            node = calloc(1, sizeof(mp_owner_node_t));
+            if (!node) { ok = false; break; }
+            __atomic_store_n(slot, node, __ATOMIC_RELEASE);
+        }
+        mp_owner_leaf_t** lslot = &node->leaves[(g >> MP_OWNER_L3_BITS) & ((1 << MP_OWNER_L2_BITS) - 1)];
+        mp_owner_leaf_t* leaf = *lslot;
+        if (!leaf) {
+            if (!owner) continue;
+            leaf = calloc(1, sizeof(mp_owner_leaf_t));
+            if (!leaf) { ok = false; break; }
+            __atomic_store_n(lslot, leaf, __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&leaf->pools[g & ((1 << MP_OWNER_L3_BITS) - 1)], owner, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_owner_lock);
+    return ok;
+}
+
+// 各页类型的页大小
+static size_t page_mode_size(mp_page_mode_t mode) {
+    switch (mode) {
+    case MP_PAGES_HUGETLB_1G: return MP_HUGE_1G;
+    case MP_PAGES_HUGETLB_2M:
+    case MP_PAGES_THP:        return MP_HUGE_2M;
+    default:                  return PAGE_SIZE;
+    }
+}
+
+// 映射池内存：起始地址至少按映射粒度对齐。*mode 为请求的页类型，大页失败时逐级回退并写回实际类型；
+// *size 按实际页大小向上取整。populate 仅对 MAP_HUGETLB 直接使用 MAP_POPULATE（其余情况多映射的余量会被一并缺页）
+static void* map_pool_memory(size_t* size, mp_page_mode_t* mode, bool populate) {
+    if (*mode == MP_PAGES_HUGETLB_1G || *mode == MP_PAGES_HUGETLB_2M) {
+        size_t huge = page_mode_size(*mode);
+        size_t len = align_size(*size, huge);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (populate ? MAP_POPULATE : 0) |
+                    ((huge == MP_HUGE_1G ? 30 : 21) << MAP_HUGE_SHIFT);
+        void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+        MP_LOG("mmap hugetlb size=%zu page=%zu -> %p", len, huge, p);
+        if (p != MAP_FAILED) {
+            *size = len;
+            return p;
+        }
+        *mode = (*mode == MP_PAGES_HUGETLB_1G) ? MP_PAGES_HUGETLB_2M : MP_PAGES_THP;
+        return map_pool_memory(size, mode, populate);
+    }
+
+    // 多映射 一个对齐单位 的余量，再裁掉首尾
+    size_t align = (*mode == MP_PAGES_THP) ? MP_HUGE_2M : MP_OWNER_GRANULE;
+    size_t len = align_size(*size, page_mode_size(*mode));
+    size_t span = len + align - PAGE_SIZE;
+    char* raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return MAP_FAILED;
+    char* start = (char*)align_size((size_t)raw, align);
+    if (start > raw) munmap(raw, (size_t)(start - raw));
+    size_t tail = (size_t)(raw + span - (start + len));
+    if (tail > 0) munmap(start + len, tail);
+    if (*mode == MP_PAGES_THP && madvise(start, len, MADV_HUGEPAGE) != 0) {
+        *mode = MP_PAGES_DEFAULT; // 内核未启用透明大页：保留映射，按普通页使用
+    }
+    *size = len;
+    return start;
+}
+
+// 预先缺页：优先 MADV_POPULATE_WRITE（5.14+），不支持时逐页做一次加0的原子写，
+// 触发写缺页但不改变内容（预热可能作用于已在使用的池，页首可能是用户数据或块头）
+static void populate_pages(void* start, size_t size, size_t page) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(start, size, MADV_POPULATE_WRITE) == 0) return;
+#endif
+    char* ptr = (char*)start;
+    for (size_t i = 0; i < size; i += page) {
+        __atomic_fetch_add(ptr + i, 0, __ATOMIC_RELAXED);
     }
 }
 
@@ -290,19 +920,53 @@ memory_pool_t* memory_pool_create_with_config(const pool_config_t* config) {
         return NULL;
     }
 
-    // 确保池大小按页对齐
+    // 确保池大小按页对齐（大页模式按大页大小，由 map_pool_memory 取整）
     size_t aligned_size = align_size(config->pool_size, PAGE_SIZE);
+    bool numa = config->numa_bind && config->numa_node >= 0 &&
+                config->numa_node < (int)(sizeof(unsigned long) * 8);
 
-    // 使用mmap分配大块内存，获得更好的性能
-    pool->pool_start = mmap(NULL, aligned_size, 
-                           PROT_READ | PROT_WRITE,
-                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    // 使用mmap分配大块内存，获得更好的性能；起始地址按映射粒度对齐，并登记到地址映射。
+    // NUMA 绑定须在缺页之前，此时不在 mmap 时预缺页
+    mp_page_mode_t page_mode = config->page_mode;
+    pool->pool_start = map_pool_memory(&aligned_size, &page_mode, config->populate && !numa);
 
     if (pool->pool_start == MAP_FAILED) {
         free(pool);
         set_error(POOL_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
+    pool->engine = config->engine;
+    pool->tlsf = (config->engine == MP_ENGINE_TLSF) ? calloc(1, sizeof(mp_tlsf_t)) : NULL;
+    if (!owner_map_set(pool->pool_start, aligned_size, pool) ||
+        (config->engine == MP_ENGINE_TLSF && !pool->tlsf)) {
+        owner_map_set(pool->pool_start, aligned_size, NULL);
+        munmap(pool->pool_start, aligned_size);
+        free(pool->tlsf);
+        free(pool);
+        set_error(POOL_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    // NUMA 放置：在首次写入前设置区域策略，之后缺页分配的物理页都落在该节点。
+    // 使用 MPOL_PREFERRED，节点内存不足时回退到其他节点而不是分配失败
+    pool->numa_node = -1;
+    if (numa) {
+        unsigned long nodemask = 1UL << config->numa_node;
+        if (syscall(SYS_mbind, pool->pool_start, aligned_size, MPOL_PREFERRED,
+                    &nodemask, sizeof(nodemask) * 8 + 1, 0) == 0) {
+            pool->numa_node = config->numa_node;
+        }
+        MP_LOG("mbind pool %p node=%d -> %d", (void*)pool, config->numa_node, pool->numa_node);
+    }
+
+    pool->page_mode = page_mode;
+    pool->page_size = page_mode_size(page_mode);
+    pool->populate = config->populate;
+    bool hugetlb = page_mode == MP_PAGES_HUGETLB_2M || page_mode == MP_PAGES_HUGETLB_1G;
+    if (config->populate && (numa || !hugetlb)) {
+        populate_pages(pool->pool_start, aligned_size, pool->page_size);
+    }
+    MP_LOG("pages pool %p mode=%d -> %d page=%zu populate=%d", (void*)pool, (int)config->page_mode, (int)page_mode, pool->page_size, (int)config->populate);
 
     pool->pool_size = aligned_size;
     pool->used_size = 0;
@@ -311,11 +975,18 @@ memory_pool_t* memory_pool_create_with_config(const pool_config_t* config) {
     pool->num_classes = 0;
     pool->next = NULL;
     pool->master = pool; // self master
+    pool->thread_cache = config->thread_cache && config->thread_safe;
+    pool->tcache_id = __atomic_fetch_add(&g_tcache_next_id, 1, __ATOMIC_RELAXED);
+    pool->tcache_list = NULL;
+    pool->percpu_slabs = NULL;
+    pool->percpu_cpus = 0;
 
     // 初始化互斥锁
     if (pool->thread_safe) {
         if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+            owner_map_set(pool->pool_start, pool->pool_size, NULL);
             munmap(pool->pool_start, pool->pool_size);
+            free(pool->tlsf);
             free(pool);
             set_error(POOL_ERROR_OUT_OF_MEMORY);
             return NULL;
@@ -325,12 +996,14 @@ memory_pool_t* memory_pool_create_with_config(const pool_config_t* config) {
     // 初始化空闲链表 - 整个池作为一个大的空闲块
     memory_block_t* initial_block = (memory_block_t*)pool->pool_start;
     initial_block->u.next = NULL;
+    initial_block->prev = NULL;
     initial_block->size = pool->pool_size;
     initial_block->magic = MAGIC_NUMBER;
     initial_block->flags = MB_FLAG_FREE;
     initial_block->rb_left = initial_block->rb_right = initial_block->rb_parent = NULL; initial_block->rb_color = 1; // root black
     pool->free_list = initial_block;
-    pool->rb_root = initial_block; // only master uses
+    pool->rb_root = NULL; // only master uses
+    index_insert(pool, initial_block);
     MP_LOG("create pool %p size=%zu align=%u", (void*)pool, pool->pool_size, pool->alignment);
 
     // 初始化固定大小池
@@ -350,6 +1023,18 @@ memory_pool_t* memory_pool_create_with_config(const pool_config_t* config) {
         }
         pool->num_classes = classes_to_add;
     }
+    rebuild_class_lut(pool);
+
+    // 每 CPU 槽位数组按可能的 CPU 数分配；不可用或分配失败时保持 NULL，走其他路径
+    if (config->percpu_cache && config->thread_safe && memory_pool_percpu_available()) {
+        long cpus = sysconf(_SC_NPROCESSORS_CONF);
+        void* slabs = NULL;
+        if (cpus > 0 && posix_memalign(&slabs, 64, (size_t)cpus * MP_PERCPU_STRIDE) == 0) {
+            memset(slabs, 0, (size_t)cpus * MP_PERCPU_STRIDE);
+            pool->percpu_slabs = slabs;
+            pool->percpu_cpus = (uint32_t)cpus;
+        }
+    }
 
     set_error(POOL_OK);
     return pool;
@@ -363,20 +1048,27 @@ static memory_pool_t* create_child_pool(memory_pool_t* root, size_t min_size) {
         .alignment = root->alignment,
         .enable_size_classes = false,
         .size_class_sizes = NULL,
-        .num_size_classes = 0
+        .num_size_classes = 0,
+        .numa_bind = root->numa_node >= 0,
+        .numa_node = root->numa_node,
+        .thread_cache = false,
+        .percpu_cache = false,
+        .page_mode = root->page_mode,
+        .populate = root->populate
     };
     memory_pool_t* child = memory_pool_create_with_config(&cfg);
     if (!child) return NULL;
     // 子池继承 master，不自建 rb_root
     memory_pool_t* master = root->master ? root->master : root;
     child->master = master;
-    // 原创建函数把自身 initial_block 设为 rb_root，需要转接到 master 的树
+    child->engine = master->engine;
+    // 原创建函数把自身 initial_block 设为 rb_root，需要转接到 master 的索引
     memory_block_t* initial_block = (memory_block_t*)child->pool_start;
     // 清理其 rb 链接后插入 master
     initial_block->rb_left = initial_block->rb_right = initial_block->rb_parent = NULL;
     initial_block->rb_color = 0; // will be recolored in insert
     child->rb_root = NULL;
-    rb_insert(master, initial_block);
+    index_insert(master, initial_block);
     // 挂到链尾
     memory_pool_t* p = root;
     while (p->next) p = p->next;
@@ -386,12 +1078,10 @@ static memory_pool_t* create_child_pool(memory_pool_t* root, size_t min_size) {
 
 // 链式查找最佳适配块，返回块与其所属池
 static memory_block_t* find_best_fit_chain(memory_pool_t* root, memory_pool_t** owner_pool, size_t size) {
-    memory_block_t* blk = rb_find_best_fit(root, size, owner_pool);
-    if (!blk) return NULL; // 仅使用红黑树，不再线性回退
-    memory_pool_t* p = *owner_pool;
-    memory_block_t* cur = p->free_list; memory_block_t* prev = NULL;
-    while (cur) { if (cur == blk) { if (prev) prev->u.next = cur->u.next; else p->free_list = cur->u.next; break; } prev = cur; cur = cur->u.next; }
-    MP_LOG("best-fit(rb) from %p blk=%p size=%zu", (void*)*owner_pool, (void*)blk, (size_t)blk->size);
+    memory_block_t* blk = index_take(root, size, owner_pool);
+    if (!blk) return NULL; // 仅使用索引（红黑树/TLSF），不再线性回退
+    unlink_free_block(*owner_pool, blk);
+    MP_LOG("best-fit(%s) from %p blk=%p size=%zu", root->engine == MP_ENGINE_TLSF ? "tlsf" : "rb", (void*)*owner_pool, (void*)blk, (size_t)blk->size);
     return blk;
 }
 
@@ -400,15 +1090,37 @@ static bool pool_contains(memory_pool_t* pool, void* ptr) {
            (char*)ptr < (char*)pool->pool_start + pool->pool_size;
 }
 
+// 找到 ptr 所属的池（须与 pool 同一条链），O(1)
+static memory_pool_t* find_owner(memory_pool_t* pool, void* ptr) {
+    memory_pool_t* owner = owner_map_get(ptr);
+    if (!owner || !pool_contains(owner, ptr) || owner->master != pool->master) return NULL;
+    return owner;
+}
+
 // 销毁内存池
 void memory_pool_destroy(memory_pool_t* pool) {
     if (!pool) return;
+    // 摘除各线程的缓存槽位（缓存的块随池一起释放）
+    if (pool->thread_cache) {
+        pthread_mutex_lock(&g_tcache_lock);
+        for (mp_tcache_entry_t* e = pool->tcache_list; e; ) {
+            mp_tcache_entry_t* next = e->next;
+            e->prev = e->next = NULL;
+            __atomic_store_n(&e->pool, NULL, __ATOMIC_RELAXED);
+            e = next;
+        }
+        pool->tcache_list = NULL;
+        pthread_mutex_unlock(&g_tcache_lock);
+    }
+    free(pool->percpu_slabs);
+    free(pool->tlsf);
     memory_pool_t* p = pool;
     while (p) {
         memory_pool_t* next = p->next;
         if (p->thread_safe) {
             pthread_mutex_destroy(&p->mutex);
         }
+        owner_map_set(p->pool_start, p->pool_size, NULL);
         munmap(p->pool_start, p->pool_size);
         free(p);
         p = next;
@@ -444,18 +1156,13 @@ void* memory_pool_alloc(memory_pool_t* pool, size_t size) {
         block = find_best_fit_chain(pool, &owner, aligned_size);
     }
     if (!block) {
-        // 仍不足，则创建子池
-        if (pool->thread_safe) {
-            pthread_mutex_unlock(&pool->mutex);
-        }
+        // 仍不足，则创建子池（持锁进行：子池会修改主池红黑树与池链）
         memory_pool_t* child = create_child_pool(pool, aligned_size);
         if (!child) {
+            if (pool->thread_safe) pthread_mutex_unlock(&pool->mutex);
             set_error(POOL_ERROR_OUT_OF_MEMORY);
             return NULL;
         }
-        if (pool->thread_safe) {
-            pthread_mutex_lock(&pool->mutex);
-        }
         owner = child;
         block = find_best_fit_chain(child, &owner, aligned_size);
         if (!block) {
@@ -503,8 +1210,8 @@ void* memory_pool_alloc_aligned(memory_pool_t* pool, size_t size, size_t alignme
 
     // 使用块总大小（包含头部），并按池对齐
     size_t used_total = align_size(size + sizeof(memory_block_t), pool->alignment);
-    // 需要预留最多 alignment 字节作为前缀填充
-    size_t min_needed = used_total + alignment;
+    // 需要预留最多 alignment 字节作为前缀填充；前缀不足 MIN_BLOCK_SIZE 时还会再后移，一并预留
+    size_t min_needed = used_total + alignment + MIN_BLOCK_SIZE;
 
     if (pool->thread_safe) {
         pthread_mutex_lock(&pool->mutex);
@@ -520,11 +1227,13 @@ void* memory_pool_alloc_aligned(memory_pool_t* pool, size_t size, size_t alignme
         block = find_best_fit_chain(pool, &owner, min_needed);
     }
     if (!block) {
-        // 仍无则创建子池后重试
-        if (pool->thread_safe) pthread_mutex_unlock(&pool->mutex);
+        // 仍无则创建子池后重试（持锁进行）
         memory_pool_t* child = create_child_pool(pool, min_needed);
-        if (!child) { set_error(POOL_ERROR_OUT_OF_MEMORY); return NULL; }
-        if (pool->thread_safe) pthread_mutex_lock(&pool->mutex);
+        if (!child) {
+            if (pool->thread_safe) pthread_mutex_unlock(&pool->mutex);
+            set_error(POOL_ERROR_OUT_OF_MEMORY);
+            return NULL;
+        }
         owner = child;
         block = find_best_fit_chain(child, &owner, min_needed);
         if (!block) {
@@ -543,7 +1252,7 @@ void* memory_pool_alloc_aligned(memory_pool_t* pool, size_t size, size_t alignme
     // 确保前缀块大小要么为0要么 >= MIN_BLOCK_SIZE；不足则前移到下一个对齐位置
     size_t prefix = (size_t)((char*)aligned_block - raw);
     if (prefix > 0 && prefix < MIN_BLOCK_SIZE) {
-        uintptr_t bumped = align_size((uintptr_t)user_min + (MIN_BLOCK_SIZE - prefix), alignment);
+        uintptr_t bumped = align_size((uintptr_t)user_min + MIN_BLOCK_SIZE, alignment);
         aligned_block = (memory_block_t*)((char*)bumped - sizeof(memory_block_t));
         prefix = (size_t)((char*)aligned_block - raw);
     }
@@ -556,10 +1265,9 @@ void* memory_pool_alloc_aligned(memory_pool_t* pool, size_t size, size_t alignme
         suffix = 0;
     }
     if (suffix > 0 && suffix < MIN_BLOCK_SIZE) {
+        // 并入后恰好铺满原块，不再取整（否则会越过原块末尾）
         used_total += suffix;
         suffix = 0;
-        // 再次按池对齐
-        used_total = align_size(used_total, pool->alignment);
     }
 
     // 前缀回收
@@ -574,17 +1282,15 @@ void* memory_pool_alloc_aligned(memory_pool_t* pool, size_t size, size_t alignme
         pre->flags &= ~MB_FLAG_PREV_FREE; // 物理首块或其前驱不一定空闲
     }
 
-    // 设置对齐后的使用块头
+    // 设置对齐后的使用块头（有前缀时块头落在原块数据区内，标志位须整体重写）
     aligned_block->size = used_total;
     aligned_block->magic = MAGIC_NUMBER;
-    aligned_block->flags &= ~MB_FLAG_FREE; // allocated
+    aligned_block->flags = 0; // allocated
+    aligned_block->u.next = NULL;
     if (prefix >= MIN_BLOCK_SIZE) {
         aligned_block->flags |= MB_FLAG_PREV_FREE;
         aligned_block->u.prev_size = (uint32_t)((memory_block_t*)raw)->size;
-    } else {
-        aligned_block->flags &= ~MB_FLAG_PREV_FREE;
     }
-    aligned_block->u.next = NULL;
 
     // 尾部回收
     if (suffix >= MIN_BLOCK_SIZE) {
@@ -635,7 +1341,7 @@ void* memory_pool_calloc(memory_pool_t* pool, size_t count, size_t size) {
     return ptr;
 }
 
-// 插入空闲块到链表中（按地址排序，便于合并）
+// 插入空闲块：放入主池红黑树，并压入所属池双向空闲链表的表头，O(1)
 static void insert_free_block(memory_pool_t* pool, memory_block_t* block) {
     if (block->flags & MB_FLAG_SIZECLASS) {
         // size-class 块不进入通用空闲链
@@ -643,20 +1349,12 @@ static void insert_free_block(memory_pool_t* pool, memory_block_t* block) {
     }
     // 标记为空闲（通用）
     block->flags |= MB_FLAG_FREE;
-    // 插入主池 RB 树（按 size 排序）
-    memory_pool_t* master = pool->master ? pool->master : pool;
-    rb_insert(master, block);
-    if (!pool->free_list || block < pool->free_list) {
-        block->u.next = pool->free_list;
-        pool->free_list = block;
-        return;
-    }
-    memory_block_t* current = pool->free_list;
-    while (current->u.next && current->u.next < block) {
-        current = current->u.next;
-    }
-    block->u.next = current->u.next;
-    current->u.next = block;
+    // 插入主池的空闲块索引（按 size 排序）
+    index_insert(pool, block);
+    block->prev = NULL;
+    block->u.next = pool->free_list;
+    if (pool->free_list) pool->free_list->prev = block;
+    pool->free_list = block;
 }
 
 // 释放内存
@@ -666,10 +1364,8 @@ void memory_pool_free(memory_pool_t* pool, void* ptr) {
         return;
     }
 
-    // 检查指针是否在池范围内
-    // 找到所属池
-    memory_pool_t* owner = pool;
-    while (owner && !pool_contains(owner, ptr)) owner = owner->next;
+    // 检查指针是否在池范围内，并找到所属池（查地址映射，无需遍历子池链，也不读取其他线程正在修改的链表）
+    memory_pool_t* owner = find_owner(pool, ptr);
     if (!owner) { set_error(POOL_ERROR_INVALID_POINTER); return; }
 
     memory_block_t* block = (memory_block_t*)((char*)ptr - sizeof(memory_block_t));
@@ -793,26 +1489,20 @@ void memory_pool_reset(memory_pool_t* pool) {
         pthread_mutex_lock(&pool->mutex);
     }
 
-    // 遍历整条链路重置
+    // 遍历整条链路重置，各池初始块重新插入 master 的索引
+    index_clear(pool->master);
     memory_pool_t* p = pool;
     while (p) {
         p->used_size = 0;
         memory_block_t* initial_block = (memory_block_t*)p->pool_start;
         initial_block->u.next = NULL;
+        initial_block->prev = NULL;
         initial_block->size = p->pool_size;
         initial_block->magic = MAGIC_NUMBER;
         initial_block->flags = MB_FLAG_FREE;
         p->free_list = initial_block;
-        if (p == pool->master) {
-            // 重建 master 根（先清空 rb_root）
-            p->rb_root = NULL;
-            initial_block->rb_left = initial_block->rb_right = initial_block->rb_parent = NULL; initial_block->rb_color = 0;
-            rb_insert(p, initial_block); // becomes root
-        } else {
-            // 将子池初始块插入 master 的树
-            initial_block->rb_left = initial_block->rb_right = initial_block->rb_parent = NULL; initial_block->rb_color = 0;
-            rb_insert(pool->master, initial_block);
-        }
+        initial_block->rb_left = initial_block->rb_right = initial_block->rb_parent = NULL; initial_block->rb_color = 0;
+        index_insert(pool, initial_block);
         MP_LOG("reset pool=%p size=%zu", (void*)p, p->pool_size);
         for (int i = 0; i < p->num_classes; i++) {
             p->size_classes[i].free_blocks = NULL;
@@ -820,6 +1510,11 @@ void memory_pool_reset(memory_pool_t* pool) {
         }
         p = p->next;
     }
+    // 清空每 CPU 槽位（reset 不允许与分配/释放并发）；更换缓存代号，各线程缓存中的旧块在下次使用时丢弃
+    if (pool->percpu_slabs) {
+        memset(pool->percpu_slabs, 0, (size_t)pool->percpu_cpus * MP_PERCPU_STRIDE);
+    }
+    __atomic_store_n(&pool->tcache_id, __atomic_fetch_add(&g_tcache_next_id, 1, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
 
     if (pool->thread_safe) {
         pthread_mutex_unlock(&pool->mutex);
@@ -829,12 +1524,7 @@ void memory_pool_reset(memory_pool_t* pool) {
 // 检查指针是否属于内存池
 bool memory_pool_contains(memory_pool_t* pool, void* ptr) {
     if (!pool || !ptr) return false;
-    memory_pool_t* p = pool;
-    while (p) {
-        if (pool_contains(p, ptr)) return true;
-        p = p->next;
-    }
-    return false;
+    return find_owner(pool, ptr) != NULL;
 }
 
 // 获取块大小
@@ -852,19 +1542,84 @@ size_t memory_pool_get_block_size(memory_pool_t* pool, void* ptr) {
     return block->size;
 }
 
+// 预热分块大小：至少一个页（1GB 大页时即为一页），保证分块边界不拆分大页
+static size_t warmup_chunk_size(const memory_pool_t* p) {
+    return p->page_size > MP_WARMUP_CHUNK ? p->page_size : MP_WARMUP_CHUNK;
+}
+
+// 整条池链按各池 warmup_chunk_size 切分后的分块总数
+size_t memory_pool_warmup_chunks(memory_pool_t* pool) {
+    size_t n = 0;
+    for (memory_pool_t* p = pool; p; p = p->next) {
+        size_t chunk = warmup_chunk_size(p);
+        n += (p->pool_size + chunk - 1) / chunk;
+    }
+    return n;
+}
+
+// 预热第 index 个分块。内存策略（mbind）在创建时已设置，由哪个线程缺页都落在绑定的节点上
+void memory_pool_warmup_chunk(memory_pool_t* pool, size_t index) {
+    for (memory_pool_t* p = pool; p; p = p->next) {
+        size_t chunk = warmup_chunk_size(p);
+        size_t count = (p->pool_size + chunk - 1) / chunk;
+        if (index < count) {
+            size_t offset = index * chunk;
+            size_t len = p->pool_size - offset < chunk ? p->pool_size - offset : chunk;
+            populate_pages((char*)p->pool_start + offset, len, p->page_size);
+            return;
+        }
+        index -= count;
+    }
+}
+
 // 内存预热
 void memory_pool_warmup(memory_pool_t* pool) {
     if (!pool) return;
     memory_pool_t* p = pool;
     while (p) {
-        volatile char* ptr = (char*)p->pool_start;
-        for (size_t i = 0; i < p->pool_size; i += PAGE_SIZE) {
-            ptr[i] = 0;
-        }
+        populate_pages(p->pool_start, p->pool_size, p->page_size);
         p = p->next;
     }
 }
 
+typedef struct {
+    memory_pool_t* pool;
+    size_t chunks;
+    size_t cursor;  // 下一个待领取的分块
+} mp_warmup_job_t;
+
+static void* warmup_worker(void* arg) {
+    mp_warmup_job_t* job = (mp_warmup_job_t*)arg;
+    size_t i;
+    while ((i = __atomic_fetch_add(&job->cursor, 1, __ATOMIC_RELAXED)) < job->chunks) {
+        memory_pool_warmup_chunk(job->pool, i);
+    }
+    return NULL;
+}
+
+// 多线程预热：调用线程加上 threads - 1 个临时线程按分块领取；线程创建失败时由已有线程完成剩余分块
+int memory_pool_warmup_parallel(memory_pool_t* pool, int threads) {
+    if (!pool) {
+        set_error(POOL_ERROR_NULL_POINTER);
+        return -1;
+    }
+    mp_warmup_job_t job = { .pool = pool, .chunks = memory_pool_warmup_chunks(pool), .cursor = 0 };
+    if (threads > MP_WARMUP_MAX_THREADS) threads = MP_WARMUP_MAX_THREADS;
+    if ((size_t)threads > job.chunks) threads = (int)job.chunks;
+
+    pthread_t tids[MP_WARMUP_MAX_THREADS];
+    int started = 0;
+    while (started < threads - 1 && pthread_create(&tids[started], NULL, warmup_worker, &job) == 0) {
+        started++;
+    }
+    warmup_worker(&job);
+    for (int k = 0; k < started; k++) {
+        pthread_join(tids[k], NULL);
+    }
+    MP_LOG("warmup pool=%p chunks=%zu threads=%d", (void*)pool, job.chunks, started + 1);
+    return 0;
+}
+
 // 内存碎片整理
 void memory_pool_defragment(memory_pool_t* pool) {
     if (!pool) return;
@@ -882,24 +1637,78 @@ void memory_pool_defragment(memory_pool_t* pool) {
     }
 }
 
-// 合并空闲块
+// 空闲块中去掉块头后、按页对齐的内部区间交还内核；下次写入时按需重新缺页（读到零页）。
+// 大页模式按大页对齐，避免拆分大页（MAP_HUGETLB 也要求如此）
+static size_t trim_free_block(memory_block_t* block, size_t page) {
+    uintptr_t start = align_size((uintptr_t)block + sizeof(memory_block_t), page);
+    uintptr_t end = ((uintptr_t)block + block->size) & ~(uintptr_t)(page - 1);
+    if (end <= start) return 0;
+    if (madvise((void*)start, end - start, MADV_DONTNEED) != 0) return 0;
+    return end - start;
+}
+
+// 内存归还
+size_t memory_pool_trim(memory_pool_t* pool) {
+    if (!pool) return 0;
+    if (pool->thread_safe) {
+        pthread_mutex_lock(&pool->mutex);
+    }
+    size_t released = 0;
+    memory_pool_t* prev = pool;
+    memory_pool_t* p = pool->next;
+    // 完全空闲的子池：从 master 索引与池链中摘除后整体解除映射（主池保留）
+    while (p) {
+        memory_pool_t* next = p->next;
+        merge_free_blocks(p);
+        memory_block_t* only = p->free_list;
+        if (p->used_size == 0 && only && only->size == p->pool_size && !only->u.next) {
+            index_remove(pool, only);
+            prev->next = next;
+            owner_map_set(p->pool_start, p->pool_size, NULL);
+            if (p->thread_safe) {
+                pthread_mutex_destroy(&p->mutex);
+            }
+            munmap(p->pool_start, p->pool_size);
+            released += p->pool_size;
+            MP_LOG("trim unmap child pool=%p size=%zu", (void*)p, p->pool_size);
+            free(p);
+        } else {
+            prev = p;
+        }
+        p = next;
+    }
+    // 其余池：逐个空闲块归还内部整页
+    for (p = pool; p; p = p->next) {
+        for (memory_block_t* b = p->free_list; b; b = b->u.next) {
+            released += trim_free_block(b, p->page_size);
+        }
+    }
+    MP_LOG("trim pool=%p released=%zu", (void*)pool, released);
+    if (pool->thread_safe) {
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    return released;
+}
+
+// 合并空闲块：链表无序，逐个检查每个空闲块的物理后继
 static void merge_free_blocks(memory_pool_t* pool) {
     if (!pool->free_list) return;
     memory_pool_t* master = pool->master ? pool->master : pool;
     memory_block_t* current = pool->free_list;
     while (current) {
         bool did_merge = false;
-        while (current->u.next && (char*)current + current->size == (char*)current->u.next) {
-            memory_block_t* next_block = current->u.next;
-            rb_remove(master, next_block);
-            current->u.next = next_block->u.next;
-            if (!did_merge) { rb_remove(master, current); did_merge = true; }
+        memory_block_t* next_block = next_physical_block(pool, current);
+        while (next_block && (next_block->flags & MB_FLAG_FREE) && !(next_block->flags & MB_FLAG_SIZECLASS)) {
+            if (!did_merge) { index_remove(master, current); did_merge = true; }
+            remove_free_block(pool, next_block);
             current->size += next_block->size;
+            next_block = next_physical_block(pool, current);
         }
         if (did_merge) {
-            rb_insert(master, current);
+            index_insert(master, current);
             set_next_prev_free(pool, current);
         }
+        // 被吸收的块已从链表摘除，current 的后继在合并后读取
         current = current->u.next;
     }
 }
@@ -917,9 +1726,11 @@ bool memory_pool_validate(memory_pool_t* pool) {
         bool valid = true;
         size_t total_free = 0;
         memory_block_t* current = p->free_list;
+        memory_block_t* prev = NULL;
         while (current) {
-            if (!validate_block(current)) { valid = false; break; }
+            if (!validate_block(current) || current->prev != prev) { valid = false; break; }
             total_free += current->size;
+            prev = current;
             current = current->u.next;
         }
     if (!(valid && (p->used_size + total_free == p->pool_size))) {
@@ -1022,6 +1833,7 @@ int memory_pool_add_size_class(memory_pool_t* pool, size_t size, size_t count) {
 
     pool->class_sizes[class_index] = size;
     pool->num_classes++;
+    rebuild_class_lut(pool);
 
     if (pool->thread_safe) {
         pthread_mutex_unlock(&pool->mutex);
@@ -1043,66 +1855,87 @@ void* memory_pool_alloc_fixed(memory_pool_t* pool, size_t size) {
     MP_ASSERT(pool->num_classes >= 0 && pool->num_classes <= MAX_SIZE_CLASSES, "invalid num_classes");
 #endif
 
-    if (pool->thread_safe) {
-        pthread_mutex_lock(&pool->mutex);
+    // 查找合适的大小类别；未找到时使用普通分配（可能链式扩展），一般不会到这里
+    int i = size_class_index(pool, size);
+    if (i < 0) {
+        return memory_pool_alloc(pool, size);
     }
 
-    // 查找合适的大小类别
-    for (int i = 0; i < pool->num_classes; i++) {
-        if (size <= pool->class_sizes[i]) {
-            size_class_pool_t* class_pool = &pool->size_classes[i];
-            
-            if (class_pool->free_blocks) {
-                memory_block_t* block = class_pool->free_blocks;
-                class_pool->free_blocks = block->u.next;
-                block->flags &= ~MB_FLAG_FREE; // allocated to user (size-class)
-                block->flags |= MB_FLAG_SIZECLASS; // keep classification
-                class_pool->used_count++;
-                
-                if (pool->thread_safe) {
-                    pthread_mutex_unlock(&pool->mutex);
-                }
-                
+#if MP_HAVE_RSEQ
+    // 每 CPU 缓存：只访问当前 CPU 的槽位，无原子操作；共享链表也为空时走下面的回退分配
+    if (pool->percpu_slabs) {
+        memory_block_t* block = percpu_alloc(pool, i);
+        if (block) {
+            set_error(POOL_OK);
+            return (char*)block + sizeof(memory_block_t);
+        }
+    } else
+#endif
+    // 线程本地缓存：命中时无需加锁，缓存为空时从共享链表批量补充
+    if (pool->thread_cache) {
+        mp_tcache_entry_t* e = tcache_entry(pool);
+        if (e) {
+            mp_magazine_t* m = &e->mags[i];
+            if (m->count == 0) {
+                tcache_refill(pool, i, m);
+            }
+            if (m->count > 0) {
+                memory_block_t* block = m->head;
+                m->head = block->u.next;
+                m->count--;
                 set_error(POOL_OK);
                 return (char*)block + sizeof(memory_block_t);
             }
-            // 没有可用的固定类块：不回退到通用“非类”分配。
-            // 释放锁后按“该类的用户大小”进行一次普通分配，内部会按需链式扩展；
-            // 分配出的块大小与该类 block_size 一致，随后计入 used_count。
-            size_t class_user_size = pool->class_sizes[i];
-            if (pool->thread_safe) {
-                pthread_mutex_unlock(&pool->mutex);
-            }
-            void* ptr = memory_pool_alloc(pool, class_user_size);
-            if (!ptr) {
-                // memory_pool_alloc 已设置错误码
-                return NULL;
-            }
-            if (pool->thread_safe) {
-                pthread_mutex_lock(&pool->mutex);
-            }
-            // 再次获取 class_pool 指针（池可能因链式扩展发生变化，但本池结构仍有效）
-            class_pool = &pool->size_classes[i];
-            class_pool->used_count++;
-#if MP_DEBUG
-            // 确认得到的块大小与该类内部块大小一致
-            size_t blk_sz = memory_pool_get_block_size(pool, ptr);
-            MP_ASSERT(blk_sz == class_pool->block_size, "alloc_fixed: block size mismatch");
-#endif
-            if (pool->thread_safe) {
-                pthread_mutex_unlock(&pool->mutex);
-            }
-            set_error(POOL_OK);
-            return ptr;
         }
     }
 
     if (pool->thread_safe) {
-        pthread_mutex_unlock(&pool->mutex);
+        pthread_mutex_lock(&pool->mutex);
     }
 
-    // 未找到匹配的固定大小类别，使用普通分配（可能链式扩展）一般不会到这里。
-    return memory_pool_alloc(pool, size);
+    size_class_pool_t* class_pool = &pool->size_classes[i];
+    if (class_pool->free_blocks) {
+        memory_block_t* block = class_pool->free_blocks;
+        class_pool->free_blocks = block->u.next;
+        block->flags &= ~MB_FLAG_FREE; // allocated to user (size-class)
+        block->flags |= MB_FLAG_SIZECLASS; // keep classification
+        class_pool->used_count++;
+
+        if (pool->thread_safe) {
+            pthread_mutex_unlock(&pool->mutex);
+        }
+
+        set_error(POOL_OK);
+        return (char*)block + sizeof(memory_block_t);
+    }
+    // 没有可用的固定类块：不回退到通用“非类”分配。
+    // 释放锁后按“该类的用户大小”进行一次普通分配，内部会按需链式扩展；
+    // 分配出的块大小与该类 block_size 一致，随后计入 used_count。
+    size_t class_user_size = pool->class_sizes[i];
+    if (pool->thread_safe) {
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    void* ptr = memory_pool_alloc(pool, class_user_size);
+    if (!ptr) {
+        // memory_pool_alloc 已设置错误码
+        return NULL;
+    }
+    if (pool->thread_safe) {
+        pthread_mutex_lock(&pool->mutex);
+    }
+    // 再次获取 class_pool 指针（池可能因链式扩展发生变化，但本池结构仍有效）
+    class_pool = &pool->size_classes[i];
+    class_pool->used_count++;
+#if MP_DEBUG
+    // 确认得到的块大小与该类内部块大小一致
+    size_t blk_sz = ((memory_block_t*)((char*)ptr - sizeof(memory_block_t)))->size;
+    MP_ASSERT(blk_sz == class_pool->block_size, "alloc_fixed: block size mismatch");
+#endif
+    if (pool->thread_safe) {
+        pthread_mutex_unlock(&pool->mutex);
+    }
+    set_error(POOL_OK);
+    return ptr;
 }
 
 // 释放到固定大小池
@@ -1119,42 +1952,55 @@ void memory_pool_free_fixed(memory_pool_t* pool, void* ptr) {
         return;
     }
 
-    if (pool->thread_safe) {
-        pthread_mutex_lock(&pool->mutex);
-    }
-
     // 检查是否属于某个固定大小类别
 #if MP_DEBUG
     MP_ASSERT(pool->num_classes >= 0 && pool->num_classes <= MAX_SIZE_CLASSES, "invalid num_classes");
 #endif
-    for (int i = 0; i < pool->num_classes; i++) {
-        if (block->size == pool->size_classes[i].block_size) {
-            size_class_pool_t* class_pool = &pool->size_classes[i];
-            
-            // 将块返回到固定大小池
-            block->flags &= ~MB_FLAG_FREE; // returning to private free list
-            block->flags |= MB_FLAG_SIZECLASS;
-            block->u.next = class_pool->free_blocks;
-            class_pool->free_blocks = block;
-            class_pool->used_count--;
-            
-            if (pool->thread_safe) {
-                pthread_mutex_unlock(&pool->mutex);
+    int i = block_class_index(pool, block->size);
+    if (i >= 0) {
+#if MP_HAVE_RSEQ
+        if (pool->percpu_slabs && (block->flags & MB_FLAG_SIZECLASS)) {
+            percpu_free(pool, i, block);
+            set_error(POOL_OK);
+            return;
+        }
+#endif
+        // 线程本地缓存：放入本线程的 magazine，超出上限时归还一批到共享链表。
+        // 首次归还的块（回退分配得到，尚无 SIZECLASS 标记）须持锁改写头部，走下面的加锁路径
+        mp_tcache_entry_t* e = (pool->thread_cache && (block->flags & MB_FLAG_SIZECLASS)) ? tcache_entry(pool) : NULL;
+        if (e) {
+            mp_magazine_t* m = &e->mags[i];
+            block->u.next = m->head;
+            m->head = block;
+            if (++m->count > MP_TCACHE_MAX) {
+                tcache_flush(pool, i, m, MP_TCACHE_BATCH);
             }
-            
             set_error(POOL_OK);
             return;
         }
-    }
 
-    if (pool->thread_safe) {
-        pthread_mutex_unlock(&pool->mutex);
+        if (pool->thread_safe) {
+            pthread_mutex_lock(&pool->mutex);
+        }
+        // 将块返回到固定大小池
+        block->flags &= ~MB_FLAG_FREE; // returning to private free list
+        block->flags |= MB_FLAG_SIZECLASS;
+        size_class_pool_t* class_pool = &pool->size_classes[i];
+        block->u.next = class_pool->free_blocks;
+        class_pool->free_blocks = block;
+        class_pool->used_count--;
+        if (pool->thread_safe) {
+            pthread_mutex_unlock(&pool->mutex);
+        }
+
+        set_error(POOL_OK);
+        return;
     }
 
-    // 不属于任何 size-class：清除 SIZECLASS 标记后走普通释放
+    // 不属于任何 size-class（alloc_fixed 回退到通用分配的块，本就不带 SIZECLASS 标记）：走普通释放。
+    // 不能在锁外改写 flags，相邻块持锁释放/分配时会改写本块的 PREV_FREE 位
 #if MP_DEBUG
     MP_LOG("free_fixed: block size %zu not matching any class -> general free", (size_t)block->size);
 #endif
-    block->flags &= ~MB_FLAG_SIZECLASS;
     memory_pool_free(pool, ptr);
 }
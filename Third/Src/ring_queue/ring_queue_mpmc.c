@@ -0,0 +1,232 @@
+#include "../../Include/ring_queue/ring_queue_mpmc.h"
+
+#ifdef DEBUG
+#include <stdio.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// 槽位：序列号后紧跟元素数据
+typedef struct {
+    _Atomic size_t sequence;
+    unsigned char data[];
+} mpmc_cell_t;
+
+// 向上取整到2的幂
+static size_t round_up_pow2(size_t n)
+{
+    size_t cap = 1;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+// 槽位地址
+static inline mpmc_cell_t *cell_at(ring_queue_mpmc_t *queue, size_t pos)
+{
+    return (mpmc_cell_t *)(queue->cells + (pos & queue->mask) * queue->cell_stride);
+}
+
+// 创建无锁队列
+ring_queue_mpmc_t* ring_queue_mpmc_create(size_t capacity, size_t elem_size)
+{
+    if (capacity == 0 || elem_size == 0) {
+#ifdef DEBUG
+        perror("[ring_queue_mpmc_create] Capacity and element size must be greater than zero.");
+#endif
+        return NULL;
+    }
+
+    ring_queue_mpmc_t *queue = NULL;
+    if (posix_memalign((void **)&queue, 64, sizeof(ring_queue_mpmc_t)) != 0) {
+#ifdef DEBUG
+        perror("[ring_queue_mpmc_create] Failed to allocate memory for ring queue.");
+#endif
+        return NULL;
+    }
+
+    capacity = round_up_pow2(capacity < 2 ? 2 : capacity);
+    // 槽位按序列号对齐
+    size_t stride = sizeof(mpmc_cell_t) + elem_size;
+    stride = (stride + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+
+    if (posix_memalign((void **)&queue->cells, 64, capacity * stride) != 0) {
+#ifdef DEBUG
+        perror("[ring_queue_mpmc_create] Failed to allocate memory for ring queue buffer.");
+#endif
+        free(queue);
+        return NULL;
+    }
+
+    queue->capacity = capacity;
+    queue->mask = capacity - 1;
+    queue->elem_size = elem_size;
+    queue->cell_stride = stride;
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&cell_at(queue, i)->sequence, i);
+    }
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+
+    return queue;
+}
+
+// 销毁无锁队列
+void ring_queue_mpmc_destroy(ring_queue_mpmc_t *queue)
+{
+    if (!queue) {
+#ifdef DEBUG
+        perror("[ring_queue_mpmc_destroy] Queue is NULL.");
+#endif
+        return;
+    }
+
+    free(queue->cells);
+    queue->cells = NULL;
+    free(queue);
+}
+
+// 入队操作
+ring_queue_status_t ring_queue_mpmc_enqueue(ring_queue_mpmc_t *queue, const void *element)
+{
+    if (!queue || !element) {
+        return RING_QUEUE_ERROR;
+    }
+
+    mpmc_cell_t *cell;
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        cell = cell_at(queue, pos);
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            // 槽位可写，抢占该位置
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 槽位仍被上一轮占用：队列已满
+            return RING_QUEUE_FULL;
+        } else {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(cell->data, element, queue->elem_size);
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+
+    return RING_QUEUE_SUCCESS;
+}
+
+// 出队操作
+ring_queue_status_t ring_queue_mpmc_dequeue(ring_queue_mpmc_t *queue, void *element)
+{
+    if (!queue || !element) {
+        return RING_QUEUE_ERROR;
+    }
+
+    mpmc_cell_t *cell;
+    size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        cell = cell_at(queue, pos);
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            // 槽位可读，抢占该位置
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 槽位尚未写入：队列为空
+            return RING_QUEUE_EMPTY;
+        } else {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(element, cell->data, queue->elem_size);
+    // 释放槽位给下一轮生产者
+    atomic_store_explicit(&cell->sequence, pos + queue->mask + 1, memory_order_release);
+
+    return RING_QUEUE_SUCCESS;
+}
+
+// 批量入队
+size_t ring_queue_mpmc_enqueue_bulk(ring_queue_mpmc_t *queue, const void *elements, size_t count)
+{
+    if (!queue || !elements || count == 0) {
+        return 0;
+    }
+
+    size_t n;
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        // 统计从 pos 起连续可写的槽位数
+        n = 0;
+        while (n < count) {
+            size_t seq = atomic_load_explicit(&cell_at(queue, pos + n)->sequence, memory_order_acquire);
+            if (seq != pos + n) {
+                break;
+            }
+            n++;
+        }
+        if (n == 0) {
+            size_t seq = atomic_load_explicit(&cell_at(queue, pos)->sequence, memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)pos < 0) {
+                return 0; // 队列已满
+            }
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+            continue;
+        }
+        // 一次 CAS 预占 n 个槽位
+        if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + n,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    const unsigned char *src = (const unsigned char *)elements;
+    for (size_t i = 0; i < n; i++) {
+        mpmc_cell_t *cell = cell_at(queue, pos + i);
+        memcpy(cell->data, src + i * queue->elem_size, queue->elem_size);
+        atomic_store_explicit(&cell->sequence, pos + i + 1, memory_order_release);
+    }
+
+    return n;
+}
+
+// 判断队列是否为空
+int ring_queue_mpmc_is_empty(ring_queue_mpmc_t *queue)
+{
+    return ring_queue_mpmc_size(queue) == 0;
+}
+
+// 获取队列当前元素数量
+size_t ring_queue_mpmc_size(ring_queue_mpmc_t *queue)
+{
+    if (!queue) {
+        return 0;
+    }
+
+    size_t tail = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    return (tail > head) ? (tail - head) : 0;
+}
+
+// 获取队列容量
+size_t ring_queue_mpmc_capacity(const ring_queue_mpmc_t *queue)
+{
+    if (!queue) {
+        return 0;
+    }
+
+    return queue->capacity;
+}
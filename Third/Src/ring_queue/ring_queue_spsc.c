@@ -0,0 +1,180 @@
+#include "../../Include/ring_queue/ring_queue_spsc.h"
+
+#ifdef DEBUG
+#include <stdio.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+// 向上取整到2的幂
+static size_t round_up_pow2(size_t n)
+{
+    size_t cap = 1;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+// 创建队列
+ring_queue_spsc_t* ring_queue_spsc_create(size_t capacity)
+{
+    if (capacity == 0) {
+#ifdef DEBUG
+        perror("[ring_queue_spsc_create] Ring queue capacity must be greater than zero.");
+#endif
+        return NULL;
+    }
+
+    ring_queue_spsc_t *queue = NULL;
+    if (posix_memalign((void **)&queue, 64, sizeof(ring_queue_spsc_t)) != 0) {
+#ifdef DEBUG
+        perror("[ring_queue_spsc_create] Failed to allocate memory for ring queue.");
+#endif
+        return NULL;
+    }
+
+    capacity = round_up_pow2(capacity);
+    queue->buffer = (void **)malloc(capacity * sizeof(void *));
+    if (!queue->buffer) {
+#ifdef DEBUG
+        perror("[ring_queue_spsc_create] Failed to allocate memory for ring queue buffer.");
+#endif
+        free(queue);
+        return NULL;
+    }
+
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cached_head = 0;
+    queue->cached_tail = 0;
+    queue->capacity = capacity;
+    queue->mask = capacity - 1;
+
+    return queue;
+}
+
+// 销毁队列
+void ring_queue_spsc_destroy(ring_queue_spsc_t *queue)
+{
+    if (!queue) {
+#ifdef DEBUG
+        perror("[ring_queue_spsc_destroy] Queue is NULL.");
+#endif
+        return;
+    }
+
+    free(queue->buffer);
+    queue->buffer = NULL;
+    free(queue);
+}
+
+// 批量入队
+size_t ring_queue_spsc_enqueue_bulk(ring_queue_spsc_t *queue, void *const *elements, size_t count)
+{
+    if (!queue || !elements || count == 0) {
+        return 0;
+    }
+
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t free_slots = queue->capacity - (tail - queue->cached_head);
+    if (free_slots < count) {
+        // 缓存值不足时才读取消费者索引
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        free_slots = queue->capacity - (tail - queue->cached_head);
+        if (free_slots == 0) {
+            return 0;
+        }
+    }
+    if (count > free_slots) {
+        count = free_slots;
+    }
+
+    // 分两段拷贝处理环绕
+    size_t idx = tail & queue->mask;
+    size_t first = queue->capacity - idx;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&queue->buffer[idx], elements, first * sizeof(void *));
+    memcpy(&queue->buffer[0], elements + first, (count - first) * sizeof(void *));
+
+    atomic_store_explicit(&queue->tail, tail + count, memory_order_release);
+    return count;
+}
+
+// 批量出队
+size_t ring_queue_spsc_dequeue_bulk(ring_queue_spsc_t *queue, void **elements, size_t count)
+{
+    if (!queue || !elements || count == 0) {
+        return 0;
+    }
+
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t avail = queue->cached_tail - head;
+    if (avail < count) {
+        // 缓存值不足时才读取生产者索引
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        avail = queue->cached_tail - head;
+        if (avail == 0) {
+            return 0;
+        }
+    }
+    if (count > avail) {
+        count = avail;
+    }
+
+    size_t idx = head & queue->mask;
+    size_t first = queue->capacity - idx;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(elements, &queue->buffer[idx], first * sizeof(void *));
+    memcpy(elements + first, &queue->buffer[0], (count - first) * sizeof(void *));
+
+    atomic_store_explicit(&queue->head, head + count, memory_order_release);
+    return count;
+}
+
+// 入队操作
+ring_queue_status_t ring_queue_spsc_enqueue(ring_queue_spsc_t *queue, void *element)
+{
+    if (!queue) {
+        return RING_QUEUE_ERROR;
+    }
+
+    return ring_queue_spsc_enqueue_bulk(queue, &element, 1) == 1 ? RING_QUEUE_SUCCESS : RING_QUEUE_FULL;
+}
+
+// 出队操作
+ring_queue_status_t ring_queue_spsc_dequeue(ring_queue_spsc_t *queue, void **element)
+{
+    if (!queue || !element) {
+        return RING_QUEUE_ERROR;
+    }
+
+    return ring_queue_spsc_dequeue_bulk(queue, element, 1) == 1 ? RING_QUEUE_SUCCESS : RING_QUEUE_EMPTY;
+}
+
+// 获取队列当前元素数量
+size_t ring_queue_spsc_size(ring_queue_spsc_t *queue)
+{
+    if (!queue) {
+        return 0;
+    }
+
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    return tail - head;
+}
+
+// 获取队列容量
+size_t ring_queue_spsc_capacity(const ring_queue_spsc_t *queue)
+{
+    if (!queue) {
+        return 0;
+    }
+
+    return queue->capacity;
+}
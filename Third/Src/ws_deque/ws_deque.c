@@ -0,0 +1,185 @@
+#include "../../Include/ws_deque/ws_deque.h"
+
+#ifdef DEBUG
+#include <stdio.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+// 向上取整到2的幂
+static size_t round_up_pow2(size_t n)
+{
+    size_t cap = 1;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+// 槽位地址
+static inline unsigned char *slot_at(ws_deque_t *deque, int64_t index)
+{
+    return deque->buffer + ((size_t)index & deque->mask) * deque->elem_size;
+}
+
+// 创建双端队列
+ws_deque_t* ws_deque_create(size_t capacity, size_t elem_size)
+{
+    if (capacity == 0 || elem_size == 0) {
+#ifdef DEBUG
+        perror("[ws_deque_create] Capacity and element size must be greater than zero.");
+#endif
+        return NULL;
+    }
+
+    ws_deque_t *deque = NULL;
+    // 结构体内 top/bottom 按缓存行对齐，需对齐分配
+    if (posix_memalign((void **)&deque, 64, sizeof(ws_deque_t)) != 0) {
+#ifdef DEBUG
+        perror("[ws_deque_create] Failed to allocate memory for deque.");
+#endif
+        return NULL;
+    }
+
+    capacity = round_up_pow2(capacity);
+    deque->buffer = (unsigned char *)malloc(capacity * elem_size);
+    if (!deque->buffer) {
+#ifdef DEBUG
+        perror("[ws_deque_create] Failed to allocate memory for deque buffer.");
+#endif
+        free(deque);
+        return NULL;
+    }
+
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    deque->capacity = capacity;
+    deque->mask = capacity - 1;
+    deque->elem_size = elem_size;
+
+    return deque;
+}
+
+// 销毁双端队列
+void ws_deque_destroy(ws_deque_t *deque)
+{
+    if (!deque) {
+#ifdef DEBUG
+        perror("[ws_deque_destroy] Deque is NULL.");
+#endif
+        return;
+    }
+
+    free(deque->buffer);
+    deque->buffer = NULL;
+    free(deque);
+}
+
+// 所有者入队
+ws_deque_status_t ws_deque_push(ws_deque_t *deque, const void *element)
+{
+    if (!deque || !element) {
+        return WS_DEQUE_ERROR;
+    }
+
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if ((size_t)(b - t) >= deque->capacity) {
+        return WS_DEQUE_FULL;
+    }
+
+    memcpy(slot_at(deque, b), element, deque->elem_size);
+    // 发布槽位内容后再推进 bottom
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+
+    return WS_DEQUE_SUCCESS;
+}
+
+// 所有者出队
+ws_deque_status_t ws_deque_pop(ws_deque_t *deque, void *element)
+{
+    if (!deque || !element) {
+        return WS_DEQUE_ERROR;
+    }
+
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b) {
+        // 队列为空，恢复 bottom
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return WS_DEQUE_EMPTY;
+    }
+
+    memcpy(element, slot_at(deque, b), deque->elem_size);
+    if (t == b) {
+        // 最后一个元素：与窃取者竞争
+        ws_deque_status_t status = WS_DEQUE_SUCCESS;
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            status = WS_DEQUE_EMPTY;
+        }
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return status;
+    }
+
+    return WS_DEQUE_SUCCESS;
+}
+
+// 窃取
+ws_deque_status_t ws_deque_steal(ws_deque_t *deque, void *element)
+{
+    if (!deque || !element) {
+        return WS_DEQUE_ERROR;
+    }
+
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (t >= b) {
+        return WS_DEQUE_EMPTY;
+    }
+
+    // 先拷贝再 CAS：若 CAS 失败，拷贝出的内容可能已被覆盖，直接丢弃
+    memcpy(element, slot_at(deque, t), deque->elem_size);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return WS_DEQUE_ABORT;
+    }
+
+    return WS_DEQUE_SUCCESS;
+}
+
+// 获取当前元素数量
+size_t ws_deque_size(ws_deque_t *deque)
+{
+    if (!deque) {
+        return 0;
+    }
+
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    return (b > t) ? (size_t)(b - t) : 0;
+}
+
+// 判断队列是否为空
+int ws_deque_is_empty(ws_deque_t *deque)
+{
+    return ws_deque_size(deque) == 0;
+}
+
+// 获取队列容量
+size_t ws_deque_capacity(const ws_deque_t *deque)
+{
+    if (!deque) {
+        return 0;
+    }
+
+    return deque->capacity;
+}
@@ -0,0 +1,756 @@
+/**
+ * 线程池、环形队列与内存池的微基准测试
+ *
+ * 每个用例重复运行若干次取中位数，结果以 JSON Lines 输出到标准输出（每行一个对象），
+ * 进度信息输出到标准错误，便于重定向保存后在版本之间对比：
+ *
+ *   {"bench":"tp_throughput","impl":"add","threads":4,"ops":200000,"ns":...,"ns_per_op":...,"ops_per_sec":...}
+ *
+ * 用法: threadpool_bench [-q] [-r 次数] [-t 最大线程数] [用例名前缀 ...]
+ *   -q  快速模式（操作数缩小为 1/10，只运行一次）
+ *   -r  每个用例重复次数（默认5）
+ *   -t  线程数扫描上限（默认为在线CPU数）
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "Threadpool.h"
+#include "ring_queue/ring_queue.h"
+#include "ring_queue/ring_queue_spsc.h"
+#include "ring_queue/ring_queue_mpmc.h"
+#include "mempool/memory_pool.h"
+
+#define BENCH_FORMAT_VERSION 1
+#define BENCH_MAX_REPEAT     32
+#define BENCH_MAX_FILTERS    16
+
+/* 命令行选项 */
+static int g_repeat = 5;
+static int g_scale = 1;             // 操作数除数（快速模式为10）
+static int g_max_threads = 0;
+static const char *g_filters[BENCH_MAX_FILTERS];
+static int g_filter_count = 0;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool bench_enabled(const char *name)
+{
+    if (g_filter_count == 0) {
+        return true;
+    }
+    for (int i = 0; i < g_filter_count; i++) {
+        if (strncmp(name, g_filters[i], strlen(g_filters[i])) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t median(uint64_t *v, int n)
+{
+    qsort(v, (size_t)n, sizeof(uint64_t), cmp_u64);
+    return v[n / 2];
+}
+
+/**
+ * 输出一行结果；extra 为附加字段（以逗号开头的 JSON 片段，可为空串）
+ */
+static void bench_report(const char *bench, const char *params, uint64_t ops, uint64_t ns, const char *extra)
+{
+    double per_op = ops ? (double)ns / (double)ops : 0.0;
+    double per_sec = ns ? (double)ops * 1e9 / (double)ns : 0.0;
+
+    printf("{\"bench\":\"%s\"%s,\"ops\":%llu,\"ns\":%llu,\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f%s}\n",
+           bench, params, (unsigned long long)ops, (unsigned long long)ns, per_op, per_sec, extra);
+    fflush(stdout);
+}
+
+/* 重复运行 fn 取耗时中位数 */
+typedef uint64_t (*bench_run_fn)(void *ctx);
+
+static uint64_t bench_median(bench_run_fn fn, void *ctx)
+{
+    uint64_t samples[BENCH_MAX_REPEAT];
+    for (int r = 0; r < g_repeat; r++) {
+        samples[r] = fn(ctx);
+    }
+    return median(samples, g_repeat);
+}
+
+/* 线程数扫描：1, 2, 4, ... 直到上限（上限本身也会包含） */
+static int next_thread_count(int n)
+{
+    if (n >= g_max_threads) {
+        return 0;
+    }
+    return (n * 2 < g_max_threads) ? n * 2 : g_max_threads;
+}
+
+/* 启动 count 个线程并等待结束，返回从全部就绪到全部结束的耗时 */
+typedef struct {
+    atomic_int ready;
+    atomic_bool go;
+} start_gate_t;
+
+static void gate_arrive(start_gate_t *gate)
+{
+    atomic_fetch_add(&gate->ready, 1);
+    while (!atomic_load_explicit(&gate->go, memory_order_acquire)) {
+        sched_yield();
+    }
+}
+
+static uint64_t run_threads(int count, void *(*fn)(void *), void *args, size_t arg_size, start_gate_t *gate)
+{
+    pthread_t threads[count];
+
+    atomic_store(&gate->ready, 0);
+    atomic_store(&gate->go, false);
+    for (int i = 0; i < count; i++) {
+        if (pthread_create(&threads[i], NULL, fn, (char *)args + (size_t)i * arg_size) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(1);
+        }
+    }
+    while (atomic_load(&gate->ready) < count) {
+        sched_yield();
+    }
+    uint64_t start = now_ns();
+    atomic_store_explicit(&gate->go, true, memory_order_release);
+    for (int i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return now_ns() - start;
+}
+
+/* ------------------------------------------------------------------------- */
+/* 线程池                                                                     */
+/* ------------------------------------------------------------------------- */
+
+static atomic_long g_done;
+
+static void empty_task(void *arg)
+{
+    (void)arg;
+    atomic_fetch_add_explicit(&g_done, 1, memory_order_relaxed);
+}
+
+static void wait_done(long target)
+{
+    while (atomic_load_explicit(&g_done, memory_order_acquire) < target) {
+        sched_yield();
+    }
+}
+
+static threadpool_t *bench_pool(int threads)
+{
+    threadpool_config_t config;
+    threadpool_config_default(&config);
+    config.thread_count = threads;
+    threadpool_t *pool = threadpool_create_with_config(&config);
+    if (pool == NULL) {
+        fprintf(stderr, "threadpool_create_with_config(%d) failed\n", threads);
+        exit(1);
+    }
+    return pool;
+}
+
+typedef struct {
+    threadpool_t *pool;
+    long ops;
+    bool batch;
+} tp_throughput_ctx_t;
+
+/* 单个提交方提交 ops 个空任务，计时到全部执行完毕 */
+static uint64_t tp_throughput_run(void *arg)
+{
+    tp_throughput_ctx_t *ctx = (tp_throughput_ctx_t *)arg;
+    threadpool_task_func funcs[64];
+    void *args[64];
+
+    for (int i = 0; i < 64; i++) {
+        funcs[i] = empty_task;
+        args[i] = NULL;
+    }
+    atomic_store(&g_done, 0);
+    uint64_t start = now_ns();
+    for (long i = 0; i < ctx->ops;) {
+        if (ctx->batch) {
+            int n = (ctx->ops - i < 64) ? (int)(ctx->ops - i) : 64;
+            i += threadpool_add_batch(ctx->pool, funcs, args, n);
+        } else if (threadpool_add(ctx->pool, empty_task, NULL) == 0) {
+            i++;
+        }
+    }
+    wait_done(ctx->ops);
+    return now_ns() - start;
+}
+
+static void bench_tp_throughput(void)
+{
+    const char *impls[] = {"add", "batch"};
+    char params[128];
+
+    for (int threads = 1; threads > 0; threads = next_thread_count(threads)) {
+        threadpool_t *pool = bench_pool(threads);
+        for (int b = 0; b < 2; b++) {
+            tp_throughput_ctx_t ctx = {pool, 1000000 / g_scale, b == 1};
+            uint64_t ns = bench_median(tp_throughput_run, &ctx);
+            snprintf(params, sizeof(params), ",\"impl\":\"%s\",\"threads\":%d", impls[b], threads);
+            bench_report("tp_throughput", params, (uint64_t)ctx.ops, ns, "");
+        }
+        threadpool_destroy(pool, THREADPOOL_GRACEFUL);
+    }
+}
+
+typedef struct {
+    threadpool_t *pool;
+    long ops;
+    uint64_t *lat;              // 每次提交的耗时
+    start_gate_t *gate;
+} tp_producer_t;
+
+static void *tp_producer(void *arg)
+{
+    tp_producer_t *p = (tp_producer_t *)arg;
+
+    gate_arrive(p->gate);
+    for (long i = 0; i < p->ops; i++) {
+        uint64_t t0 = now_ns();
+        while (threadpool_add(p->pool, empty_task, NULL) != 0) {
+            sched_yield();
+        }
+        p->lat[i] = now_ns() - t0;
+    }
+    return NULL;
+}
+
+/* 1..N 个提交方并发提交，统计单次 threadpool_add 的耗时分布 */
+static void bench_tp_submit_latency(void)
+{
+    int threads = g_max_threads;
+    long ops = 200000 / g_scale;
+    threadpool_t *pool = bench_pool(threads);
+    char params[128], extra[160];
+
+    for (int producers = 1; producers > 0; producers = next_thread_count(producers)) {
+        tp_producer_t prod[producers];
+        start_gate_t gate;
+        uint64_t *lat = (uint64_t *)malloc(sizeof(uint64_t) * (size_t)ops * (size_t)producers);
+        uint64_t samples[BENCH_MAX_REPEAT];
+        if (lat == NULL) {
+            exit(1);
+        }
+        for (int r = 0; r < g_repeat; r++) {
+            atomic_store(&g_done, 0);
+            for (int i = 0; i < producers; i++) {
+                prod[i] = (tp_producer_t){pool, ops, lat + (size_t)i * (size_t)ops, &gate};
+            }
+            samples[r] = run_threads(producers, tp_producer, prod, sizeof(tp_producer_t), &gate);
+            wait_done(ops * producers);
+        }
+        // 分位数取最后一轮全部样本
+        size_t total = (size_t)ops * (size_t)producers;
+        qsort(lat, total, sizeof(uint64_t), cmp_u64);
+        snprintf(params, sizeof(params), ",\"threads\":%d,\"producers\":%d", threads, producers);
+        snprintf(extra, sizeof(extra), ",\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu",
+                 (unsigned long long)lat[total / 2], (unsigned long long)lat[total * 99 / 100],
+                 (unsigned long long)lat[total * 999 / 1000], (unsigned long long)lat[total - 1]);
+        bench_report("tp_submit_latency", params, total, median(samples, g_repeat), extra);
+        free(lat);
+    }
+    threadpool_destroy(pool, THREADPOOL_GRACEFUL);
+}
+
+typedef struct {
+    threadpool_t *pool;
+    int width;                  // 每轮扇出的任务数
+    long rounds;
+} tp_fanout_ctx_t;
+
+static void *future_task(void *arg)
+{
+    return arg;
+}
+
+static void range_task(size_t begin, size_t end, void *ctx)
+{
+    long sum = 0;
+    for (size_t i = begin; i < end; i++) {
+        sum += (long)(i & 1);
+    }
+    atomic_fetch_add_explicit((atomic_long *)ctx, sum, memory_order_relaxed);
+}
+
+/* 任务组：每轮加入 width 个空任务后等待全部完成 */
+static uint64_t tp_fanout_group_run(void *arg)
+{
+    tp_fanout_ctx_t *ctx = (tp_fanout_ctx_t *)arg;
+    uint64_t start = now_ns();
+
+    for (long r = 0; r < ctx->rounds; r++) {
+        threadpool_group_t *group = threadpool_group_create(ctx->pool);
+        for (int i = 0; i < ctx->width; i++) {
+            threadpool_group_add(group, empty_task, NULL);
+        }
+        threadpool_group_wait(group);
+        threadpool_group_destroy(group);
+    }
+    return now_ns() - start;
+}
+
+/* future：每轮提交 width 个任务后逐个等待结果 */
+static uint64_t tp_fanout_future_run(void *arg)
+{
+    tp_fanout_ctx_t *ctx = (tp_fanout_ctx_t *)arg;
+    threadpool_future_t *futures[ctx->width];
+    uint64_t start = now_ns();
+
+    for (long r = 0; r < ctx->rounds; r++) {
+        for (int i = 0; i < ctx->width; i++) {
+            futures[i] = threadpool_submit_future(ctx->pool, future_task, NULL);
+        }
+        for (int i = 0; i < ctx->width; i++) {
+            if (futures[i] != NULL) {
+                threadpool_future_wait(futures[i], NULL);
+                threadpool_future_destroy(futures[i]);
+            }
+        }
+    }
+    return now_ns() - start;
+}
+
+/* parallel_for：每轮处理 width 个元素（自动分块） */
+static uint64_t tp_fanout_parallel_for_run(void *arg)
+{
+    tp_fanout_ctx_t *ctx = (tp_fanout_ctx_t *)arg;
+    atomic_long sum = 0;
+    uint64_t start = now_ns();
+
+    for (long r = 0; r < ctx->rounds; r++) {
+        threadpool_parallel_for(ctx->pool, 0, (size_t)ctx->width, 0, range_task, &sum);
+    }
+    uint64_t ns = now_ns() - start;
+    if (atomic_load(&sum) != ctx->rounds * (ctx->width / 2)) {
+        fprintf(stderr, "parallel_for: unexpected sum %ld\n", atomic_load(&sum));
+        exit(1);
+    }
+    return ns;
+}
+
+static void bench_tp_fanout(void)
+{
+    int threads = g_max_threads;
+    threadpool_t *pool = bench_pool(threads);
+    char params[128];
+    static const struct {
+        const char *impl;
+        bench_run_fn run;
+        int width;
+        long rounds;
+    } cases[] = {
+        {"group", tp_fanout_group_run, 64, 20000},
+        {"group", tp_fanout_group_run, 1024, 2000},
+        {"future", tp_fanout_future_run, 64, 20000},
+        {"parallel_for", tp_fanout_parallel_for_run, 1 << 20, 200},
+    };
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        tp_fanout_ctx_t ctx = {pool, cases[c].width, cases[c].rounds / g_scale};
+        uint64_t ns = bench_median(cases[c].run, &ctx);
+        snprintf(params, sizeof(params), ",\"impl\":\"%s\",\"threads\":%d,\"width\":%d",
+                 cases[c].impl, threads, cases[c].width);
+        // 每轮（一次扇出+汇合）为一个操作
+        bench_report("tp_fanout", params, (uint64_t)ctx.rounds, ns, "");
+    }
+    threadpool_destroy(pool, THREADPOOL_GRACEFUL);
+}
+
+/* ------------------------------------------------------------------------- */
+/* 环形队列                                                                   */
+/* ------------------------------------------------------------------------- */
+
+#define RQ_CAPACITY 1024
+
+typedef struct {
+    long ops;
+} rq_ctx_t;
+
+/* 通用环形队列（非线程安全）：单线程入队后出队 */
+static uint64_t rq_basic_run(void *arg)
+{
+    rq_ctx_t *ctx = (rq_ctx_t *)arg;
+    ring_queue_t *q = ring_queue_create(RQ_CAPACITY, NULL);
+    void *elem;
+    uint64_t start = now_ns();
+
+    for (long i = 0; i < ctx->ops; i += RQ_CAPACITY / 2) {
+        for (long k = 0; k < RQ_CAPACITY / 2; k++) {
+            ring_queue_enqueue(q, (void *)(intptr_t)(k + 1));
+        }
+        for (long k = 0; k < RQ_CAPACITY / 2; k++) {
+            ring_queue_peek(q, &elem);
+            ring_queue_dequeue(q);
+        }
+    }
+    uint64_t ns = now_ns() - start;
+    ring_queue_destroy(q);
+    return ns;
+}
+
+typedef struct {
+    ring_queue_spsc_t *spsc;
+    ring_queue_mpmc_t *mpmc;
+    long ops;
+    bool producer;
+    start_gate_t *gate;
+} rq_worker_t;
+
+static void *rq_spsc_worker(void *arg)
+{
+    rq_worker_t *w = (rq_worker_t *)arg;
+    void *elem;
+
+    gate_arrive(w->gate);
+    for (long i = 0; i < w->ops; i++) {
+        if (w->producer) {
+            while (ring_queue_spsc_enqueue(w->spsc, (void *)(intptr_t)(i + 1)) != RING_QUEUE_SUCCESS) {
+                sched_yield();
+            }
+        } else {
+            while (ring_queue_spsc_dequeue(w->spsc, &elem) != RING_QUEUE_SUCCESS) {
+                sched_yield();
+            }
+        }
+    }
+    return NULL;
+}
+
+static void *rq_mpmc_worker(void *arg)
+{
+    rq_worker_t *w = (rq_worker_t *)arg;
+    uint64_t elem = 0;
+
+    gate_arrive(w->gate);
+    for (long i = 0; i < w->ops; i++) {
+        if (w->producer) {
+            elem = (uint64_t)i;
+            while (ring_queue_mpmc_enqueue(w->mpmc, &elem) != RING_QUEUE_SUCCESS) {
+                sched_yield();
+            }
+        } else {
+            while (ring_queue_mpmc_dequeue(w->mpmc, &elem) != RING_QUEUE_SUCCESS) {
+                sched_yield();
+            }
+        }
+    }
+    return NULL;
+}
+
+static void bench_ring_queue(void)
+{
+    rq_ctx_t ctx = {10000000 / g_scale};
+    char params[128];
+    start_gate_t gate;
+
+    bench_report("ring_queue", ",\"impl\":\"basic\",\"producers\":1,\"consumers\":1",
+                 (uint64_t)ctx.ops, bench_median(rq_basic_run, &ctx), "");
+
+    // SPSC：一个生产者线程，一个消费者线程；每个元素计一次操作
+    long ops = 5000000 / g_scale;
+    uint64_t samples[BENCH_MAX_REPEAT];
+    for (int r = 0; r < g_repeat; r++) {
+        ring_queue_spsc_t *q = ring_queue_spsc_create(RQ_CAPACITY);
+        rq_worker_t w[2] = {{q, NULL, ops, true, &gate}, {q, NULL, ops, false, &gate}};
+        samples[r] = run_threads(2, rq_spsc_worker, w, sizeof(rq_worker_t), &gate);
+        ring_queue_spsc_destroy(q);
+    }
+    bench_report("ring_queue", ",\"impl\":\"spsc\",\"producers\":1,\"consumers\":1",
+                 (uint64_t)ops, median(samples, g_repeat), "");
+
+    // MPMC：n 个生产者、n 个消费者
+    for (int n = 1; n > 0; n = next_thread_count(n)) {
+        if (n * 2 > g_max_threads && n > 1) {
+            break;
+        }
+        long per = 4000000 / g_scale / n;
+        rq_worker_t w[n * 2];
+        for (int r = 0; r < g_repeat; r++) {
+            ring_queue_mpmc_t *q = ring_queue_mpmc_create(RQ_CAPACITY, sizeof(uint64_t));
+            for (int i = 0; i < n * 2; i++) {
+                w[i] = (rq_worker_t){NULL, q, per, i < n, &gate};
+            }
+            samples[r] = run_threads(n * 2, rq_mpmc_worker, w, sizeof(rq_worker_t), &gate);
+            ring_queue_mpmc_destroy(q);
+        }
+        snprintf(params, sizeof(params), ",\"impl\":\"mpmc\",\"producers\":%d,\"consumers\":%d", n, n);
+        bench_report("ring_queue", params, (uint64_t)(per * n), median(samples, g_repeat), "");
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* 内存池                                                                     */
+/* ------------------------------------------------------------------------- */
+
+#define MP_LIVE 1024                // 每轮同时存活的块数
+
+typedef enum {
+    MP_IMPL_POOL,                   // memory_pool_alloc / memory_pool_free
+    MP_IMPL_TLSF,                   // 同上，TLSF 引擎
+    MP_IMPL_FIXED,                  // memory_pool_alloc_fixed / memory_pool_free_fixed
+    MP_IMPL_TCACHE,                 // 同上，启用线程本地缓存
+    MP_IMPL_PERCPU,                 // 同上，启用每 CPU 缓存（rseq）
+    MP_IMPL_MALLOC                  // glibc malloc / free
+} mp_impl_t;
+
+static const char *mp_impl_names[] = {"pool", "pool_tlsf", "fixed", "fixed_tcache", "fixed_percpu", "malloc"};
+
+/* 大小分布：[min, max] 内按 xorshift 均匀取值 */
+typedef struct {
+    const char *name;
+    size_t min;
+    size_t max;
+} mp_dist_t;
+
+static const mp_dist_t mp_dists[] = {
+    {"fixed64", 64, 64},
+    {"small", 16, 256},
+    {"mixed", 16, 4096},
+    {"large", 4096, 65536},
+};
+
+typedef struct {
+    memory_pool_t *pool;
+    mp_impl_t impl;
+    const mp_dist_t *dist;
+    long rounds;
+    unsigned int seed;
+    start_gate_t *gate;
+} mp_worker_t;
+
+static inline unsigned int xorshift(unsigned int *s)
+{
+    unsigned int x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+/* 每轮分配 MP_LIVE 块（写入首字节）后按随机顺序释放 */
+static void mp_rounds(mp_worker_t *w)
+{
+    void *ptrs[MP_LIVE];
+    size_t sizes[MP_LIVE];
+    unsigned int seed = w->seed;
+
+    for (int i = 0; i < MP_LIVE; i++) {
+        sizes[i] = w->dist->min + xorshift(&seed) % (w->dist->max - w->dist->min + 1);
+    }
+    for (long r = 0; r < w->rounds; r++) {
+        for (int i = 0; i < MP_LIVE; i++) {
+            switch (w->impl) {
+            case MP_IMPL_POOL:
+            case MP_IMPL_TLSF:
+                ptrs[i] = memory_pool_alloc(w->pool, sizes[i]);
+                break;
+            case MP_IMPL_FIXED:
+            case MP_IMPL_TCACHE:
+            case MP_IMPL_PERCPU:
+                ptrs[i] = memory_pool_alloc_fixed(w->pool, sizes[i]);
+                break;
+            default:
+                ptrs[i] = malloc(sizes[i]);
+                break;
+            }
+            if (ptrs[i] != NULL) {
+                *(volatile char *)ptrs[i] = (char)i;
+            }
+        }
+        // 打乱释放顺序
+        for (int i = MP_LIVE - 1; i > 0; i--) {
+            int j = (int)(xorshift(&seed) % (unsigned int)(i + 1));
+            void *t = ptrs[i];
+            ptrs[i] = ptrs[j];
+            ptrs[j] = t;
+        }
+        for (int i = 0; i < MP_LIVE; i++) {
+            switch (w->impl) {
+            case MP_IMPL_POOL:
+            case MP_IMPL_TLSF:
+                memory_pool_free(w->pool, ptrs[i]);
+                break;
+            case MP_IMPL_FIXED:
+            case MP_IMPL_TCACHE:
+            case MP_IMPL_PERCPU:
+                memory_pool_free_fixed(w->pool, ptrs[i]);
+                break;
+            default:
+                free(ptrs[i]);
+                break;
+            }
+        }
+    }
+}
+
+static void *mp_worker(void *arg)
+{
+    mp_worker_t *w = (mp_worker_t *)arg;
+    gate_arrive(w->gate);
+    mp_rounds(w);
+    return NULL;
+}
+
+static memory_pool_t *mp_create(mp_impl_t impl, const mp_dist_t *dist, bool thread_safe)
+{
+    if (impl == MP_IMPL_MALLOC) {
+        return NULL;
+    }
+    pool_config_t config;
+    size_t class_size = dist->max;
+    memset(&config, 0, sizeof(config));
+    config.pool_size = 64 * 1024 * 1024;
+    config.thread_safe = thread_safe;
+    config.alignment = 16;
+    config.engine = (impl == MP_IMPL_TLSF) ? MP_ENGINE_TLSF : MP_ENGINE_RBTREE;
+    if (impl == MP_IMPL_FIXED || impl == MP_IMPL_TCACHE || impl == MP_IMPL_PERCPU) {
+        config.enable_size_classes = true;
+        config.size_class_sizes = &class_size;
+        config.num_size_classes = 1;
+        config.thread_cache = (impl == MP_IMPL_TCACHE);
+        config.percpu_cache = (impl == MP_IMPL_PERCPU);
+    }
+    memory_pool_t *pool = memory_pool_create_with_config(&config);
+    if (pool == NULL) {
+        fprintf(stderr, "memory_pool_create_with_config failed\n");
+        exit(1);
+    }
+    return pool;
+}
+
+static void bench_mempool(void)
+{
+    char params[160];
+    start_gate_t gate;
+
+    for (size_t d = 0; d < sizeof(mp_dists) / sizeof(mp_dists[0]); d++) {
+        const mp_dist_t *dist = &mp_dists[d];
+        long rounds = ((dist->max > 4096) ? 200 : 2000) / g_scale;
+
+        for (int impl = MP_IMPL_POOL; impl <= MP_IMPL_MALLOC; impl++) {
+            // 固定大小池只适用于单一尺寸
+            if ((impl == MP_IMPL_FIXED || impl == MP_IMPL_TCACHE || impl == MP_IMPL_PERCPU) && dist->min != dist->max) {
+                continue;
+            }
+            for (int threads = 1; threads > 0; threads = next_thread_count(threads)) {
+                memory_pool_t *pool = mp_create((mp_impl_t)impl, dist, threads > 1);
+                mp_worker_t w[threads];
+                uint64_t samples[BENCH_MAX_REPEAT];
+                for (int r = 0; r < g_repeat; r++) {
+                    for (int i = 0; i < threads; i++) {
+                        w[i] = (mp_worker_t){pool, (mp_impl_t)impl, dist, rounds,
+                                             2463534242u + (unsigned int)i * 7919u, &gate};
+                    }
+                    samples[r] = run_threads(threads, mp_worker, w, sizeof(mp_worker_t), &gate);
+                }
+                if (pool != NULL) {
+                    memory_pool_destroy(pool);
+                }
+                // 一次分配加一次释放计为一个操作
+                snprintf(params, sizeof(params), ",\"impl\":\"%s\",\"dist\":\"%s\",\"min\":%zu,\"max\":%zu,\"threads\":%d",
+                         mp_impl_names[impl], dist->name, dist->min, dist->max, threads);
+                bench_report("mempool", params, (uint64_t)rounds * MP_LIVE * (uint64_t)threads,
+                             median(samples, g_repeat), "");
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} benches[] = {
+    {"tp_throughput", bench_tp_throughput},
+    {"tp_submit_latency", bench_tp_submit_latency},
+    {"tp_fanout", bench_tp_fanout},
+    {"ring_queue", bench_ring_queue},
+    {"mempool", bench_mempool},
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "用法: %s [-q] [-r 次数] [-t 最大线程数] [用例名前缀 ...]\n用例:", prog);
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        fprintf(stderr, " %s", benches[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, "qr:t:h")) != -1) {
+        switch (opt) {
+        case 'q':
+            g_scale = 10;
+            g_repeat = 1;
+            break;
+        case 'r':
+            g_repeat = atoi(optarg);
+            break;
+        case 't':
+            g_max_threads = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 2;
+        }
+    }
+    for (; optind < argc && g_filter_count < BENCH_MAX_FILTERS; optind++) {
+        g_filters[g_filter_count++] = argv[optind];
+    }
+    if (g_repeat < 1 || g_repeat > BENCH_MAX_REPEAT) {
+        fprintf(stderr, "重复次数需在 1 ~ %d 之间\n", BENCH_MAX_REPEAT);
+        return 2;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (g_max_threads <= 0) {
+        g_max_threads = (cpus > 0) ? (int)cpus : 1;
+    }
+
+    // 首行记录运行环境，便于区分不同机器上的结果
+    printf("{\"bench\":\"meta\",\"version\":%d,\"cpus\":%ld,\"max_threads\":%d,\"repeat\":%d,\"scale\":%d,"
+           "\"compiler\":\"%s\",\"time\":%ld}\n",
+           BENCH_FORMAT_VERSION, cpus, g_max_threads, g_repeat, g_scale, __VERSION__, (long)time(NULL));
+
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        if (!bench_enabled(benches[i].name)) {
+            continue;
+        }
+        fprintf(stderr, "[bench] %s\n", benches[i].name);
+        benches[i].run();
+    }
+    return 0;
+}
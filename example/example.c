@@ -14,7 +14,7 @@ __thread size_t thread_id; // 线程ID
 // 任务函数
 void task_function(void *arg) 
 {
-    int task_id = *(int*)arg;
+    int task_id = *(int*)arg; // 内联参数：指向任务自身携带的副本
     thread_id = pthread_self();
 
     // 模拟任务执行时间 (0.1-1秒)
@@ -26,8 +26,6 @@ void task_function(void *arg)
     map[task_id] = true; // 标记任务完成
     printf("任务 %d 由线程 %lu 完成，耗时 %.2f 秒\n", task_id, thread_id, sleep_time/1000000.0);
     pthread_mutex_unlock(&print_lock);
-    
-    free(arg); // 释放参数内存
 }
 
 int main() 
@@ -49,20 +47,12 @@ int main()
     // 添加30个任务到线程池
     int i;
     for (i = 0; i < 30; i++) {
-        int *task_id = (int*)malloc(sizeof(int));
-        if (task_id == NULL) {
-            fprintf(stderr, "内存分配失败\n");
-            continue;
-        }
-        
-        *task_id = i;
-        
         printf("添加任务 %d 到线程池\n", i);
-        int ret = threadpool_add(pool, task_function, task_id);
+        // 任务ID随任务内联存放，无需 malloc/free
+        int ret = threadpool_add_inline(pool, task_function, &i, sizeof(i));
         
         if (ret != 0) {
             fprintf(stderr, "任务 %d 添加失败，错误码: %d\n", i, ret);
-            free(task_id);
         }
         
         // 短暂延迟，方便观察